@@ -0,0 +1,161 @@
+export module Benchmark;
+
+import std.compat;
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+// Just enough of a benchmark harness for the engine: ns/op, allocations/op, JSON lines out, and a diff against a saved run.
+export namespace Benchmark
+{
+	// Bumped by the replaced global operator new of the executable. Thread local, the measured thread is the only one that counts.
+	inline thread_local uint64_t t_allocations = 0;
+
+	struct result_t final
+	{
+		string m_name{};
+		size_t m_size{};	// number of dice, or tokens.
+		uint64_t m_iterations{};
+		double m_ns_per_op{};
+		double m_allocs_per_op{};
+	};
+
+	// Keeps the optimizer from throwing the work away.
+	template <typename T>
+	void DoNotOptimize(T const& val) noexcept
+	{
+		static std::atomic<void const*> sink{};
+		sink.store(&val, std::memory_order_relaxed);
+	}
+
+	// Repeats fn() until the batch lasts long enough to trust the clock, then reports the average of the last batch.
+	template <typename F>
+	result_t Measure(string szName, size_t size, F&& fn) noexcept
+	{
+		using clock = std::chrono::steady_clock;
+		static constexpr auto MIN_DURATION = std::chrono::milliseconds(50);
+
+		fn();	// warm up, caches and lazily built tables alike.
+
+		for (uint64_t iterations = 1;; iterations *= 2)
+		{
+			auto const allocs_before = t_allocations;
+			auto const start = clock::now();
+
+			for (uint64_t i = 0; i < iterations; ++i)
+				fn();
+
+			auto const elapsed = clock::now() - start;
+
+			if (elapsed >= MIN_DURATION || iterations >= (uint64_t(1) << 30))
+			{
+				return result_t{
+					.m_name{ std::move(szName) },
+					.m_size{ size },
+					.m_iterations{ iterations },
+					.m_ns_per_op{ std::chrono::duration<double, std::nano>(elapsed).count() / (double)iterations },
+					.m_allocs_per_op{ (double)(t_allocations - allocs_before) / (double)iterations },
+				};
+			}
+		}
+	}
+
+	// One JSON object per line, so that a baseline could be read back without a JSON library.
+	string ToJsonLines(vector<result_t> const& rgResults) noexcept
+	{
+		string ret{};
+
+		for (auto&& res : rgResults)
+		{
+			std::format_to(
+				std::back_inserter(ret),
+				"{{\"name\":\"{}\",\"size\":{},\"iterations\":{},\"ns_per_op\":{:.3f},\"allocs_per_op\":{:.3f}}}\n",
+				res.m_name, res.m_size, res.m_iterations, res.m_ns_per_op, res.m_allocs_per_op
+			);
+		}
+
+		return ret;
+	}
+
+	// Reads back what ToJsonLines() wrote, and nothing else.
+	vector<result_t> FromJsonLines(string_view szJson) noexcept
+	{
+		auto const ValueOf =
+			[](string_view szLine, string_view szKey) noexcept -> string_view
+			{
+				auto const key = std::format("\"{}\":", szKey);
+				auto pos = szLine.find(key);
+
+				if (pos == szLine.npos)
+					return {};
+
+				pos += key.size();
+				auto const end = szLine.find_first_of(",}", szLine[pos] == '"' ? szLine.find('"', pos + 1) : pos);
+
+				auto ret = szLine.substr(pos, end - pos);
+
+				if (ret.size() >= 2 && ret.front() == '"')
+					ret = ret.substr(1, ret.size() - 2);
+
+				return ret;
+			};
+
+		auto const NumberOf =
+			[](string_view sz) noexcept
+			{
+				double ret{};
+				std::from_chars(sz.data(), sz.data() + sz.size(), ret);
+				return ret;
+			};
+
+		vector<result_t> ret{};
+
+		for (auto&& line : szJson | std::views::split('\n'))
+		{
+			string_view const szLine{ line.begin(), line.end() };
+
+			if (szLine.find('{') == szLine.npos)
+				continue;
+
+			ret.push_back(result_t{
+				.m_name{ string{ ValueOf(szLine, "name") } },
+				.m_size{ (size_t)NumberOf(ValueOf(szLine, "size")) },
+				.m_iterations{ (uint64_t)NumberOf(ValueOf(szLine, "iterations")) },
+				.m_ns_per_op{ NumberOf(ValueOf(szLine, "ns_per_op")) },
+				.m_allocs_per_op{ NumberOf(ValueOf(szLine, "allocs_per_op")) },
+			});
+		}
+
+		return ret;
+	}
+
+	// Human readable, to stderr. Slope is the local exponent of the scaling curve, log(t2 / t1) / log(n2 / n1).
+	void Report(vector<result_t> const& rgResults, vector<result_t> const& rgBaseline) noexcept
+	{
+		static constexpr double NOISE = 0.10;
+
+		std::print(stderr, "{:<28}{:>6}{:>14}{:>12}{:>8}{:>12}\n", "benchmark", "size", "ns/op", "allocs/op", "slope", "baseline");
+
+		for (auto&& [i, res] : std::views::enumerate(rgResults))
+		{
+			string szSlope{};
+
+			if (i > 0 && rgResults[i - 1].m_name == res.m_name && rgResults[i - 1].m_size > 0 && res.m_size > rgResults[i - 1].m_size)
+			{
+				auto const& prev = rgResults[i - 1];
+				szSlope = std::format("{:.2f}", std::log(res.m_ns_per_op / prev.m_ns_per_op) / std::log((double)res.m_size / (double)prev.m_size));
+			}
+
+			string szBaseline{};
+
+			if (auto const it = std::ranges::find_if(rgBaseline, [&](result_t const& base) noexcept { return base.m_name == res.m_name && base.m_size == res.m_size; }); it != rgBaseline.end())
+			{
+				auto const ratio = res.m_ns_per_op / it->m_ns_per_op;
+				szBaseline = std::format("{:.2f}x{}", ratio, ratio > 1 + NOISE ? " !" : (ratio < 1 - NOISE ? " +" : ""));
+			}
+
+			std::print(stderr, "{:<28}{:>6}{:>14.1f}{:>12.2f}{:>8}{:>12}\n", res.m_name, res.m_size, res.m_ns_per_op, res.m_allocs_per_op, szSlope, szBaseline);
+		}
+	}
+}
@@ -0,0 +1,483 @@
+export module Bytecode;
+
+import std.compat;
+
+using std::span;
+using std::string;
+using std::string_view;
+using std::vector;
+
+using namespace std::literals;
+
+// RPN from ShuntingYardAlgorithm() compiled into flat instructions, every token decoded once and for all.
+// Running a program then never looks at a string again, and the operand stack of a trivial type never touches the heap.
+// Variables are bound by slot on each run, so a templated formula such as (1d8 + STR) * 2 is compiled only once.
+// Dice may carry mechanics after their face, applied in the order written:
+//	r2	reroll a 2 once			r<3	reroll anything below 3 once
+//	min2	anything below 2 counts as 2
+//	!	explode on the highest face, as deep as the domain sees fit	!4	at most 4 extra rolls
+// And at most one of these on the whole pool, after every die is done with its own:
+//	kh3	keep the 3 highest		kl3	keep the 3 lowest
+//	dh1	drop the highest one		dl1	drop the lowest one
+//	s8	count the dice of 8 or more instead of adding them up, and c10 makes the ones of 10 or more count twice.
+export namespace Bytecode
+{
+	enum struct op_t : uint8_t
+	{
+		CONSTANT,
+		DICE,
+		VARIABLE,
+
+		ADD,
+		SUBTRACT,
+		MULTIPLY,
+		DIVIDE,
+		MODULO,
+		POWER,
+		FACTORIAL,
+	};
+
+	struct instruction_t final
+	{
+		op_t m_op{};
+		uint8_t m_slot{};	// VARIABLE, or the mechanics of DICE counting from 1, 0 being none.
+		int16_t m_count{};	// DICE
+		int32_t m_value{};	// CONSTANT, or the face of DICE.
+	};
+
+	static_assert(sizeof(instruction_t) == 8);
+
+	enum struct mechanic_t : uint8_t
+	{
+		REROLL,
+		REROLL_BELOW,
+		MINIMUM,
+		EXPLODE,
+		CRITICAL,	// along with SUCCESS only.
+
+		// of the pool
+		KEEP_HIGHEST,
+		KEEP_LOWEST,
+		DROP_HIGHEST,
+		DROP_LOWEST,
+		SUCCESS,
+	};
+
+	struct die_mechanic_t final
+	{
+		mechanic_t m_kind{};
+		int16_t m_value{};	// the face to reroll, the threshold, the minimum, the depth of explosion with -1 for the default, or how many to keep or drop.
+
+		constexpr bool OfPool() const noexcept { return m_kind >= mechanic_t::KEEP_HIGHEST; }
+
+		constexpr bool operator== (die_mechanic_t const&) const noexcept = default;
+	};
+
+	inline constexpr size_t MAX_DEPTH = 64;
+	inline constexpr size_t MAX_VARIABLES = 256;
+	inline constexpr size_t MAX_MECHANICS = 255;
+
+	struct program_t final
+	{
+		constexpr std::optional<size_t> SlotOf(string_view szName) const noexcept
+		{
+			if (auto const it = std::ranges::find(m_variables, szName); it != m_variables.end())
+				return it - m_variables.begin();
+
+			return std::nullopt;
+		}
+
+		// e.g. whether the result is a count of successes rather than a sum.
+		constexpr bool Uses(mechanic_t kind) const noexcept
+		{
+			return std::ranges::any_of(m_mechanics | std::views::join, [kind](die_mechanic_t const& mechanic) noexcept { return mechanic.m_kind == kind; });
+		}
+
+		vector<instruction_t> m_code{};
+		vector<string> m_variables{};	// names by slot.
+		vector<vector<die_mechanic_t>> m_mechanics{};	// by slot of DICE, minus one.
+		size_t m_max_depth{};
+	};
+
+	constexpr std::optional<op_t> OperatorOf(char c) noexcept
+	{
+		switch (c)
+		{
+		case '+': return op_t::ADD;
+		case '-': return op_t::SUBTRACT;
+		case '*': return op_t::MULTIPLY;
+		case '/': return op_t::DIVIDE;
+		case '%': return op_t::MODULO;
+		case '^': return op_t::POWER;
+		case '!': return op_t::FACTORIAL;
+
+		default:
+			return std::nullopt;
+		}
+	}
+
+	template <typename T>
+	constexpr std::optional<T> NumberOf(string_view sz) noexcept
+	{
+		if (T ret{}; !sz.empty() && std::from_chars(sz.data(), sz.data() + sz.size(), ret) == std::from_chars_result{ sz.data() + sz.size(), std::errc{} })
+			return ret;
+
+		return std::nullopt;
+	}
+
+	constexpr bool IsIdentifier(string_view sz) noexcept
+	{
+		auto const IsAlpha = [](char c) noexcept { return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || c == '_'; };
+		auto const IsAlnum = [&](char c) noexcept { return IsAlpha(c) || ('0' <= c && c <= '9'); };
+
+		return !sz.empty() && IsAlpha(sz.front()) && std::ranges::all_of(sz, IsAlnum);
+	}
+
+	// Die or dice, e.g. d6, 2d6, 2D6 or 2d6r<3
+	constexpr bool IsDice(string_view token) noexcept
+	{
+		auto const pos = token.find_first_of("dD");
+
+		return pos != token.npos && !IsIdentifier(token.substr(pos + 1)) && (pos == 0 || NumberOf<int16_t>(token.substr(0, pos)));
+	}
+
+	// Whatever follows the face, e.g. "r<3min2" or "!4"
+	constexpr std::expected<vector<die_mechanic_t>, string> MechanicsOf(string_view sz) noexcept
+	{
+		vector<die_mechanic_t> ret{};
+
+		while (!sz.empty())
+		{
+			auto const szMechanic = sz;
+			die_mechanic_t mechanic{};
+
+			if (sz.starts_with("r<"))
+				mechanic.m_kind = mechanic_t::REROLL_BELOW, sz.remove_prefix(2);
+			else if (sz.starts_with("r"))
+				mechanic.m_kind = mechanic_t::REROLL, sz.remove_prefix(1);
+			else if (sz.starts_with("min"))
+				mechanic.m_kind = mechanic_t::MINIMUM, sz.remove_prefix(3);
+			else if (sz.starts_with("!"))
+				mechanic.m_kind = mechanic_t::EXPLODE, sz.remove_prefix(1);
+			else if (sz.starts_with("kh"))
+				mechanic.m_kind = mechanic_t::KEEP_HIGHEST, sz.remove_prefix(2);
+			else if (sz.starts_with("kl"))
+				mechanic.m_kind = mechanic_t::KEEP_LOWEST, sz.remove_prefix(2);
+			else if (sz.starts_with("dh"))
+				mechanic.m_kind = mechanic_t::DROP_HIGHEST, sz.remove_prefix(2);
+			else if (sz.starts_with("dl"))
+				mechanic.m_kind = mechanic_t::DROP_LOWEST, sz.remove_prefix(2);
+			else if (sz.starts_with("s"))
+				mechanic.m_kind = mechanic_t::SUCCESS, sz.remove_prefix(1);
+			else if (sz.starts_with("c"))
+				mechanic.m_kind = mechanic_t::CRITICAL, sz.remove_prefix(1);
+			else
+				return std::unexpected(std::format(u8"無效輸入：無法解讀骰子機制'{}'\n", sz));
+
+			auto const digits = std::min(sz.find_first_not_of("0123456789"), sz.size());
+
+			if (auto const value = NumberOf<int16_t>(sz.substr(0, digits)); value)
+				mechanic.m_value = *value;
+			else if (mechanic.m_kind == mechanic_t::EXPLODE && digits == 0)
+				mechanic.m_value = -1;
+			else
+				return std::unexpected(std::format(u8"格式錯誤：骰子機制缺少數值。\n\t錯誤位於'{}'處。\n", szMechanic));
+
+			sz.remove_prefix(digits);
+
+			if (mechanic.OfPool() && std::ranges::any_of(ret, &die_mechanic_t::OfPool))
+				return std::unexpected(std::format(u8"格式錯誤：每組骰子只能保留、捨棄或計算成功其中一次。\n\t錯誤位於'{}'處。\n", szMechanic));
+
+			ret.push_back(mechanic);
+		}
+
+		auto const success = std::ranges::find(ret, mechanic_t::SUCCESS, &die_mechanic_t::m_kind);
+		auto const critical = std::ranges::find(ret, mechanic_t::CRITICAL, &die_mechanic_t::m_kind);
+
+		if (critical != ret.end() && success == ret.end())
+			return std::unexpected(string{ u8"格式錯誤：加倍成功'c'須與成功門檻's'並用。\n" });
+
+		// A die short of the threshold is no success at all, let alone a double one.
+		if (critical != ret.end() && critical->m_value < success->m_value)
+			return std::unexpected(std::format(u8"格式錯誤：加倍成功'c{}'不可低於成功門檻's{}'。\n", critical->m_value, success->m_value));
+
+		return ret;
+	}
+
+	static_assert(
+		IsDice("d6") && IsDice("2D6") && IsDice("2d6r<3") && !IsDice("dex") && !IsDice("x2d6")
+		&& MechanicsOf("r<3min2!").value() == vector<die_mechanic_t>{ { mechanic_t::REROLL_BELOW, 3 }, { mechanic_t::MINIMUM, 2 }, { mechanic_t::EXPLODE, -1 } }
+		&& MechanicsOf("!4r1").value() == vector<die_mechanic_t>{ { mechanic_t::EXPLODE, 4 }, { mechanic_t::REROLL, 1 } }
+		&& IsDice("4d6dl1") && MechanicsOf("r1kh3").value() == vector<die_mechanic_t>{ { mechanic_t::REROLL, 1 }, { mechanic_t::KEEP_HIGHEST, 3 } }
+		&& MechanicsOf("s8c10").value() == vector<die_mechanic_t>{ { mechanic_t::SUCCESS, 8 }, { mechanic_t::CRITICAL, 10 } }
+	);
+
+	constexpr std::expected<program_t, string> Compile(span<string_view const> rgszRPN) noexcept
+	{
+		program_t ret{};
+		size_t depth = 0;
+
+		ret.m_code.reserve(rgszRPN.size());
+
+		for (auto&& token : rgszRPN)
+		{
+			instruction_t ins{};
+
+			if (auto const op = token.length() == 1 ? OperatorOf(token[0]) : std::nullopt; op)
+			{
+				size_t const arg_count = *op == op_t::FACTORIAL ? 1 : 2;
+
+				if (depth < arg_count)
+					return std::unexpected(std::format(u8"格式錯誤：運算子'{}'缺少運算元。\n", token));
+
+				ins.m_op = *op;
+				depth -= arg_count - 1;
+			}
+
+			else if (IsDice(token))
+			{
+				auto const pos = token.find_first_of("dD");
+				auto const szFace = token.substr(pos + 1);
+				auto const digits = std::min(szFace.find_first_not_of("0123456789"), szFace.size());
+				auto const face = NumberOf<int16_t>(szFace.substr(0, digits));
+
+				if (!face || *face == 0)
+					return std::unexpected(std::format(u8"格式錯誤：未指明骰子面數。\n\t錯誤位於'{}'處。\n", token));
+
+				if (digits < szFace.size())
+				{
+					auto mechanics = MechanicsOf(szFace.substr(digits));
+
+					if (!mechanics)
+						return std::unexpected(std::move(mechanics).error());
+
+					if (ret.m_mechanics.size() >= MAX_MECHANICS)
+						return std::unexpected(std::format(u8"無效輸入：附有機制的骰子多於{}組。\n", MAX_MECHANICS));
+
+					ret.m_mechanics.push_back(std::move(*mechanics));
+					ins.m_slot = (uint8_t)ret.m_mechanics.size();
+				}
+
+				ins.m_op = op_t::DICE;
+				ins.m_count = pos == 0 ? 1 : *NumberOf<int16_t>(token.substr(0, pos));
+				ins.m_value = *face;
+				++depth;
+			}
+
+			else if (auto const value = NumberOf<int32_t>(token); value)
+			{
+				ins.m_op = op_t::CONSTANT;
+				ins.m_value = *value;
+				++depth;
+			}
+
+			else if (IsIdentifier(token))
+			{
+				auto slot = ret.SlotOf(token);
+
+				if (!slot)
+				{
+					if (ret.m_variables.size() >= MAX_VARIABLES)
+						return std::unexpected(std::format(u8"無效輸入：變數多於{}個。\n", MAX_VARIABLES));
+
+					slot = ret.m_variables.size();
+					ret.m_variables.emplace_back(token);
+				}
+
+				ins.m_op = op_t::VARIABLE;
+				ins.m_slot = (uint8_t)*slot;
+				++depth;
+			}
+
+			else
+				return std::unexpected(std::format(u8"無效輸入：無法解讀'{}'\n", token));
+
+			if (depth > MAX_DEPTH)
+				return std::unexpected(std::format(u8"無效輸入：算式巢狀多於{}層。\n", MAX_DEPTH));
+
+			ret.m_max_depth = std::max(ret.m_max_depth, depth);
+			ret.m_code.push_back(ins);
+		}
+
+		if (depth != 1)
+			return std::unexpected(string{ u8"格式錯誤：「運算子」應與「骰子」交替。\n" });
+
+		return ret;
+	}
+
+	// Operands of trivial types live on a fixed array, others on a vector reserved once.
+	template <typename T>
+	struct operand_stack_t final
+	{
+		static inline constexpr bool FIXED = std::is_trivially_copyable_v<T> && std::is_trivially_default_constructible_v<T>;
+
+		constexpr explicit operand_stack_t(size_t max_depth) noexcept
+		{
+			if constexpr (!FIXED)
+				m_storage.reserve(max_depth);
+		}
+
+		constexpr void Push(T&& val) noexcept
+		{
+			if constexpr (FIXED)
+				m_storage[m_size++] = val;
+			else
+				m_storage.push_back(std::move(val));
+		}
+
+		constexpr T Pop() noexcept
+		{
+			if constexpr (FIXED)
+				return m_storage[--m_size];
+			else
+			{
+				auto ret = std::move(m_storage.back());
+				m_storage.pop_back();
+				return ret;
+			}
+		}
+
+		std::conditional_t<FIXED, std::array<T, MAX_DEPTH>, vector<T>> m_storage{};
+		size_t m_size{};	// FIXED only.
+	};
+
+	// The domain gives meaning to the program:
+	//	T Constant(int32_t)
+	//	std::expected<T, string> Dice(int16_t count, int16_t face)
+	//	std::expected<T, string> Dice(int16_t count, int16_t face, span<die_mechanic_t const>), optional, as without it dice with mechanics are refused.
+	//	std::expected<T, string> Apply(op_t, T const& lhs, T const& rhs)
+	//	std::expected<T, string> Factorial(T const&)
+	template <typename T, typename D>
+	constexpr std::expected<T, string> Execute(program_t const& program, span<int32_t const> rgiBindings, D&& domain) noexcept
+	{
+		if (rgiBindings.size() < program.m_variables.size())
+			return std::unexpected(std::format(u8"無效輸入：變數'{}'未指定數值。\n", program.m_variables[rgiBindings.size()]));
+
+		operand_stack_t<T> stack{ program.m_max_depth };
+
+		for (auto&& ins : program.m_code)
+		{
+			switch (ins.m_op)
+			{
+			case op_t::CONSTANT:
+				stack.Push(domain.Constant(ins.m_value));
+				break;
+
+			case op_t::VARIABLE:
+				stack.Push(domain.Constant(rgiBindings[ins.m_slot]));
+				break;
+
+			case op_t::DICE:
+			{
+				std::expected<T, string> res{ std::unexpect };
+
+				if (ins.m_slot == 0)
+					res = domain.Dice(ins.m_count, (int16_t)ins.m_value);
+				else if constexpr (requires { domain.Dice(ins.m_count, (int16_t)ins.m_value, span<die_mechanic_t const>{}); })
+					res = domain.Dice(ins.m_count, (int16_t)ins.m_value, program.m_mechanics[ins.m_slot - 1]);
+				else
+					return std::unexpected(std::format(u8"無效輸入：此處不接受骰子機制'{}d{}'\n", ins.m_count, ins.m_value));
+
+				if (!res)
+					return res;
+
+				stack.Push(std::move(*res));
+				break;
+			}
+
+			case op_t::FACTORIAL:
+			{
+				auto res = domain.Factorial(stack.Pop());
+
+				if (!res)
+					return res;
+
+				stack.Push(std::move(*res));
+				break;
+			}
+
+			default:
+			{
+				auto const rhs = stack.Pop();
+				auto const lhs = stack.Pop();
+				auto res = domain.Apply(ins.m_op, lhs, rhs);
+
+				if (!res)
+					return res;
+
+				stack.Push(std::move(*res));
+				break;
+			}
+			}
+		}
+
+		return stack.Pop();
+	}
+
+	// Plain integers, which is what PostfixNotationEval() always did. Dice have no single value here.
+	struct integer_domain_t final
+	{
+		/*#UPDATE_AT_CPP23_static_operator*/ constexpr int32_t Constant(int32_t val) const noexcept { return val; }
+
+		std::expected<int32_t, string> Dice(int16_t count, int16_t face) const noexcept
+		{
+			return std::unexpected(std::format(u8"無效輸入：整數算式不接受骰子'{}d{}'\n", count, face));
+		}
+
+		constexpr std::expected<int32_t, string> Apply(op_t op, int32_t lhs, int32_t rhs) const noexcept
+		{
+			switch (op)
+			{
+			case op_t::ADD:
+				return lhs + rhs;
+			case op_t::SUBTRACT:
+				return lhs - rhs;
+			case op_t::MULTIPLY:
+				return lhs * rhs;
+
+			case op_t::DIVIDE:
+			case op_t::MODULO:
+				if (rhs == 0)
+					return std::unexpected(string{ u8"無效輸入：除數為零。\n" });
+
+				return op == op_t::DIVIDE ? lhs / rhs : lhs % rhs;
+
+			case op_t::POWER:
+			{
+				int32_t ret = 1;
+				for (int32_t i = 0; i < rhs; ++i)
+					ret *= lhs;
+
+				return ret;
+			}
+
+			default:
+				std::unreachable();
+			}
+		}
+
+		constexpr std::expected<int32_t, string> Factorial(int32_t n) const noexcept
+		{
+			int32_t ret = 1;
+			for (; n > 1; --n)
+				ret *= n;
+
+			return ret;
+		}
+	};
+
+	static_assert(
+		[]() consteval
+		{
+			// (STR + 2) * PB - STR, and (2d6)(3) which leaves two operands behind.
+			auto const program = Compile(vector<string_view>{ "STR", "2", "+", "PB", "*", "STR", "-" });
+
+			return program
+				&& program->m_variables.size() == 2
+				&& Execute<int32_t>(*program, std::array{ 3, 4 }, integer_domain_t{}) == 17
+				&& !Compile(vector<string_view>{ "2d6", "3" }).has_value()
+				&& Compile(vector<string_view>{ "4d6s5" }).value().Uses(mechanic_t::SUCCESS)
+				&& !Compile(vector<string_view>{ "4d6r1" }).value().Uses(mechanic_t::SUCCESS);
+		}()
+	);
+}
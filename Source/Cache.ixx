@@ -0,0 +1,133 @@
+export module Cache;
+
+import std.compat;
+
+// Process wide, thread safe, size bounded cache.
+// Entries are spread over shards, each one with its own reader-writer lock, so readers of different shards never meet.
+// Eviction is approximately LRU: every hit stamps the entry with the shard clock, and the stalest entry goes first.
+export template <typename K, typename V, typename H = std::hash<K>, size_t SHARD_COUNT = 16>
+struct sharded_cache_t final
+{
+	struct stats_t final
+	{
+		uint64_t m_hits{};
+		uint64_t m_misses{};
+		uint64_t m_evictions{};
+		size_t m_size{};
+	};
+
+	explicit sharded_cache_t(size_t capacity) noexcept
+		: m_shard_capacity{ std::max<size_t>(1, capacity / SHARD_COUNT) }
+	{
+	}
+
+	sharded_cache_t(sharded_cache_t const&) noexcept = delete;
+	sharded_cache_t& operator= (sharded_cache_t const&) noexcept = delete;
+
+	std::shared_ptr<V const> Find(K const& key) noexcept
+	{
+		auto ret = Peek(key);
+
+		if (ret)
+			m_hits.fetch_add(1, std::memory_order_relaxed);
+		else
+			m_misses.fetch_add(1, std::memory_order_relaxed);
+
+		return ret;
+	}
+
+	// Same as Find(), but leaves hit/miss counters alone. For speculative lookups.
+	std::shared_ptr<V const> Peek(K const& key) noexcept
+	{
+		auto& shard = ShardOf(key);
+		std::shared_lock lock{ shard.m_mutex };
+
+		if (auto const it = shard.m_entries.find(key); it != shard.m_entries.end())
+		{
+			it->second.m_last_used.store(shard.m_clock.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+			return it->second.m_value;
+		}
+
+		return nullptr;
+	}
+
+	// Returns what actually stays in the cache, which would be the earlier one if someone else had been faster.
+	std::shared_ptr<V const> Insert(K key, std::shared_ptr<V const> value) noexcept
+	{
+		auto& shard = ShardOf(key);
+		std::unique_lock lock{ shard.m_mutex };
+
+		if (auto const it = shard.m_entries.find(key); it != shard.m_entries.end())
+			return it->second.m_value;
+
+		if (shard.m_entries.size() >= m_shard_capacity)
+		{
+			auto const stalest = std::ranges::min_element(
+				shard.m_entries, {},
+				[](auto&& pr) noexcept { return pr.second.m_last_used.load(std::memory_order_relaxed); }
+			);
+
+			shard.m_entries.erase(stalest);
+			m_evictions.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		auto const [it, _] = shard.m_entries.try_emplace(
+			std::move(key),
+			std::move(value), shard.m_clock.fetch_add(1, std::memory_order_relaxed)
+		);
+
+		return it->second.m_value;
+	}
+
+	stats_t Stats() noexcept
+	{
+		stats_t ret{
+			.m_hits{ m_hits.load(std::memory_order_relaxed) },
+			.m_misses{ m_misses.load(std::memory_order_relaxed) },
+			.m_evictions{ m_evictions.load(std::memory_order_relaxed) },
+		};
+
+		for (auto&& shard : m_shards)
+		{
+			std::shared_lock lock{ shard.m_mutex };
+			ret.m_size += shard.m_entries.size();
+		}
+
+		return ret;
+	}
+
+	void Clear() noexcept
+	{
+		for (auto&& shard : m_shards)
+		{
+			std::unique_lock lock{ shard.m_mutex };
+			shard.m_entries.clear();
+		}
+	}
+
+private:
+	struct entry_t final
+	{
+		entry_t(std::shared_ptr<V const> value, uint64_t stamp) noexcept : m_value{ std::move(value) }, m_last_used{ stamp } {}
+
+		std::shared_ptr<V const> m_value{};
+		std::atomic<uint64_t> m_last_used{};	// bumped under shared lock.
+	};
+
+	// Own cache line each, or the locks of neighbours would ping-pong.
+	struct alignas(std::hardware_destructive_interference_size) shard_t final
+	{
+		std::shared_mutex m_mutex{};
+		std::unordered_map<K, entry_t, H> m_entries{};
+		std::atomic<uint64_t> m_clock{};
+	};
+
+	shard_t& ShardOf(K const& key) noexcept { return m_shards[H{}(key) % SHARD_COUNT]; }
+
+	std::array<shard_t, SHARD_COUNT> m_shards{};
+	size_t const m_shard_capacity{};
+
+	std::atomic<uint64_t> m_hits{};
+	std::atomic<uint64_t> m_misses{};
+	std::atomic<uint64_t> m_evictions{};
+};
@@ -11,10 +11,18 @@ import std.compat;
 
 #include <version>	// all marcos.
 
+import Bytecode;
+import Benchmark;
+import Cache;
+import Executor;
+import Kernel;
+import Server;
+import Store;
 import Utility;
 
 using std::array;
 using std::pair;
+using std::span;
 using std::string;
 using std::string_view;
 using std::tuple;
@@ -60,501 +68,3737 @@ namespace Arithmatic
 	static_assert(DigitsOf(10) == 2);
 	static_assert(DigitsOf(-10) == 2);
 	static_assert(DigitsOf(100u) == 3);
-}
 
-namespace Statistics
-{
-	constexpr int16_t Confidence(int32_t minimum, vector<double> const& rgflPercentages) noexcept
+	constexpr uint64_t PowMod(uint64_t base, uint64_t exp, uint64_t mod) noexcept
 	{
-		for (auto&& [iDamage, flChance] : std::views::zip(std::views::iota(minimum), rgflPercentages))
+		uint64_t ret = 1 % mod;
+
+		for (base %= mod; exp; exp >>= 1, base = base * base % mod)
 		{
-			if (flChance > 0.005)	// Greater than 0.5%
-				return (int16_t)iDamage;
+			if (exp & 1)
+				ret = ret * base % mod;
 		}
 
-		return (int16_t)-1;
+		return ret;
 	}
 
-	constexpr int16_t Confidence(int32_t minimum, vector<double> const& rgflPercentages, double flChance) noexcept
+	// Deterministic Miller-Rabin, bases 2, 7, 61 cover every 32 bits number.
+	constexpr bool IsPrime(uint32_t n) noexcept
 	{
-		auto tmp = 1.0 - flChance;
+		if (n < 2)
+			return false;
 
-		for (auto&& [iDamage, flChance] : std::views::zip(std::views::iota(minimum), rgflPercentages))
+		for (uint32_t p : { 2u, 3u, 5u, 7u, 11u, 13u, 61u })
 		{
-			tmp -= flChance;
-
-			if (tmp <= 0)
-				return (int16_t)iDamage;
+			if (n % p == 0)
+				return n == p;
 		}
 
-		return (int16_t)-1;
-	}
+		auto d = n - 1;
+		auto r = 0;
 
-	constexpr auto IntervalEstimate(vector<double> const& rgflPercentages, int16_t iLeftBound, int16_t iRightBound, double flStdDev) noexcept
-	{
-		auto tmp{ 1.0 };
+		for (; d % 2 == 0; d /= 2)
+			++r;
 
-		for (auto&& [iDamage, flChance] : std::views::zip(std::views::iota(iLeftBound), rgflPercentages))
+		for (uint64_t a : { 2u, 7u, 61u })
 		{
-			tmp -= 2 * flChance;	// symmetric
+			auto x = PowMod(a, d, n);
 
-			if (tmp < flStdDev)
-				break;
+			if (x == 1 || x == n - 1)
+				continue;
 
-			++iLeftBound;
-			--iRightBound;
+			auto composite = true;
 
-			if (iLeftBound > iRightBound)
-				break;	// ERROR!
+			for (auto i = 1; i < r && composite; ++i)
+			{
+				x = x * x % n;
+				composite = x != n - 1;
+			}
+
+			if (composite)
+				return false;
 		}
 
-		return pair{ iLeftBound, iRightBound };
+		return true;
 	}
 
-	constexpr auto Challenge(int16_t minimum, vector<double> const& rgflPercentages, int16_t dc) noexcept
+	static_assert(PowMod(3, 200, 1000000007) == 136318165);
+	static_assert(IsPrime(998244353) and IsPrime(2013265921) and !IsPrime(2013265923) and !IsPrime(1) and IsPrime(2));
+
+	// Arbitrary precision unsigned integer, just enough for counting dice outcomes.
+	// Little endian 32 bits limbs, no leading zero limb. Zero has no limb at all.
+	struct big_uint_t final
 	{
-		double pass{};
+		constexpr big_uint_t() noexcept = default;
+		constexpr big_uint_t(uint64_t n) noexcept { for (; n; n >>= 32) m_limbs.push_back(static_cast<uint32_t>(n)); }
 
-		for (auto&& [iResult, flChance] : std::views::zip(std::views::iota(minimum), rgflPercentages))
+		constexpr bool IsZero() const noexcept { return m_limbs.empty(); }
+		constexpr size_t Bits() const noexcept { return m_limbs.empty() ? 0 : (m_limbs.size() - 1) * 32 + std::bit_width(m_limbs.back()); }
+
+		constexpr big_uint_t& operator+= (big_uint_t const& rhs) noexcept
 		{
-			if (iResult < dc)
-				continue;
+			if (m_limbs.size() < rhs.m_limbs.size())
+				m_limbs.resize(rhs.m_limbs.size());
 
-			pass += flChance;
-		}
+			uint64_t carry = 0;
 
-		return pass;
-	}
+			for (size_t i = 0; i < m_limbs.size(); ++i)
+			{
+				if (!carry && i >= rhs.m_limbs.size())
+					break;
 
-	constexpr auto ChallengeEx(int32_t minimum, vector<double> const& rgflPercentages, int16_t dc) noexcept
-	{
-		double pass{};
+				carry += (uint64_t)m_limbs[i] + (i < rhs.m_limbs.size() ? rhs.m_limbs[i] : 0);
+				m_limbs[i] = static_cast<uint32_t>(carry);
+				carry >>= 32;
+			}
 
-		for (auto&& [iResult, flChance] : std::views::zip(std::views::iota(minimum), rgflPercentages))
-		{
-			if (iResult < dc)
-				continue;
+			if (carry)
+				m_limbs.push_back(static_cast<uint32_t>(carry));
 
-			pass += flChance;
+			return *this;
 		}
 
-		auto const fail = 1.0 - pass;
-		auto const pass_when_adv = 1.0 - fail * fail;
-		auto const pass_when_disadv = pass * pass;
+		// Caller must guarantee *this >= rhs.
+		constexpr big_uint_t& operator-= (big_uint_t const& rhs) noexcept
+		{
+			uint32_t borrow = 0;
 
-		return tuple{
-			pass,
-			pass_when_adv,
-			pass_when_disadv,
-		};
-	}
+			for (size_t i = 0; i < m_limbs.size(); ++i)
+			{
+				if (!borrow && i >= rhs.m_limbs.size())
+					break;
 
-	constexpr auto Possibilities(vector<int16_t> const& dice) noexcept
-	{
-		return std::ranges::fold_left(
-			dice | std::views::transform([](int16_t n) noexcept -> uint64_t { return n < 0 ? -n : n; }),	// promote!
-			1,
-			std::multiplies<>{}
-		);
-	}
+				auto const sub = (uint64_t)(i < rhs.m_limbs.size() ? rhs.m_limbs[i] : 0) + borrow;
+				borrow = m_limbs[i] < sub;
+				m_limbs[i] = static_cast<uint32_t>(m_limbs[i] - sub);
+			}
 
-	constexpr auto LowerBound(int16_t modifier, vector<int16_t> const& dice) noexcept
-	{
-		auto const fn =
-			[](int16_t n) noexcept -> int16_t
+			Trim();
+			return *this;
+		}
+
+		// *this = *this * mul + add
+		constexpr big_uint_t& MulAdd(uint32_t mul, uint32_t add) noexcept
+		{
+			uint64_t carry = add;
+
+			for (auto&& limb : m_limbs)
 			{
-				// lowest: substraction die takes its maximum and others take minimum.
-				return n < 0 ? n : 1;
-			};
+				carry += (uint64_t)limb * mul;
+				limb = static_cast<uint32_t>(carry);
+				carry >>= 32;
+			}
 
-		// force the return type to be int16_t rather than promoted int32_t.
-		return std::ranges::fold_left(dice | std::views::transform(fn), modifier, std::plus<int16_t>{});
-	}
+			if (carry)
+				m_limbs.push_back(static_cast<uint32_t>(carry));
 
-	constexpr auto UpperBound(int16_t modifier, vector<int16_t> const& dice) noexcept
-	{
-		auto const fn =
-			[](int16_t n) noexcept -> int16_t
+			Trim();
+			return *this;
+		}
+
+		// In place division, returns the remainder.
+		constexpr uint32_t DivMod(uint32_t divisor) noexcept
+		{
+			uint64_t rem = 0;
+
+			for (auto&& limb : m_limbs | std::views::reverse)
 			{
-				// highest: substraction die takes its minimum and others take maximum.
-				return n < 0 ? -1 : n;
-			};
+				auto const cur = (rem << 32) | limb;
+				limb = static_cast<uint32_t>(cur / divisor);
+				rem = cur % divisor;
+			}
 
-		// force the return type to be int16_t rather than promoted int32_t.
-		return std::ranges::fold_left(dice | std::views::transform(fn), modifier, std::plus<int16_t>{});
-	}
+			Trim();
+			return static_cast<uint32_t>(rem);
+		}
 
-	constexpr auto Range(int16_t modifier, vector<int16_t> const& dice) noexcept { return pair{ LowerBound(modifier, dice), UpperBound(modifier, dice) }; }
+		constexpr uint32_t Mod(uint32_t divisor) const noexcept
+		{
+			uint64_t rem = 0;
 
-	constexpr auto Distribution(int16_t modifier, int16_t lower_bound, int16_t upper_bound, vector<int16_t> const& dice) noexcept
-	{
-		auto const offset = modifier - lower_bound;
-		auto const should_reserve = upper_bound - lower_bound + 1;
+			for (auto&& limb : m_limbs | std::views::reverse)
+				rem = ((rem << 32) | limb) % divisor;
+
+			return static_cast<uint32_t>(rem);
+		}
 
-		vector<uint64_t> ret{};	// flat map? #UPDATE_AT_CPP23_flat_meow
-		ret.resize(should_reserve);
+		string ToString() const noexcept
+		{
+			if (IsZero())
+				return "0";
+
+			vector<uint32_t> chunks{};	// base 10^9, little endian.
+
+			for (auto copy{ *this }; !copy.IsZero();)
+				chunks.push_back(copy.DivMod(1'000'000'000));
+
+			auto ret = std::format("{}", chunks.back());
+
+			for (auto&& chunk : chunks | std::views::reverse | std::views::drop(1))
+				ret += std::format("{:09}", chunk);
+
+			return ret;
+		}
+
+		friend constexpr big_uint_t operator+ (big_uint_t lhs, big_uint_t const& rhs) noexcept { return lhs += rhs; }
 
-		auto const fnIterateAllDice =
-			[&](this auto&& self, int16_t val, size_t index) noexcept
+		friend constexpr big_uint_t operator* (big_uint_t const& lhs, big_uint_t const& rhs) noexcept
+		{
+			if (lhs.IsZero() || rhs.IsZero())
+				return {};
+
+			big_uint_t ret{};
+			ret.m_limbs.resize(lhs.m_limbs.size() + rhs.m_limbs.size());
+
+			for (size_t i = 0; i < lhs.m_limbs.size(); ++i)
 			{
-				if (index == dice.size())
+				uint64_t carry = 0;	// (2^32 - 1)^2 + 2 * (2^32 - 1) never exceeds 2^64 - 1
+
+				for (size_t j = 0; j < rhs.m_limbs.size(); ++j)
 				{
-					++ret[val + offset];
-					return;
+					carry += (uint64_t)lhs.m_limbs[i] * rhs.m_limbs[j] + ret.m_limbs[i + j];
+					ret.m_limbs[i + j] = static_cast<uint32_t>(carry);
+					carry >>= 32;
 				}
 
-				auto const start = dice[index] < 0 ? dice[index] : 1;
-				auto const stop = dice[index] < 0 ? -1 : dice[index];
+				ret.m_limbs[i + rhs.m_limbs.size()] = static_cast<uint32_t>(carry);
+			}
 
-				for (auto i = start; i <= stop; ++i)
-				{
-					self(val + i, index + 1);
-				}
-			};
+			ret.Trim();
+			return ret;
+		}
 
-		fnIterateAllDice(0, 0);
-		return ret;
-	}
+		friend constexpr bool operator== (big_uint_t const& lhs, big_uint_t const& rhs) noexcept = default;
+
+		friend constexpr std::strong_ordering operator<=> (big_uint_t const& lhs, big_uint_t const& rhs) noexcept
+		{
+			if (lhs.m_limbs.size() != rhs.m_limbs.size())
+				return lhs.m_limbs.size() <=> rhs.m_limbs.size();
+
+			return std::lexicographical_compare_three_way(lhs.m_limbs.rbegin(), lhs.m_limbs.rend(), rhs.m_limbs.rbegin(), rhs.m_limbs.rend());
+		}
+
+		constexpr void Trim() noexcept
+		{
+			while (!m_limbs.empty() && m_limbs.back() == 0)
+				m_limbs.pop_back();
+		}
+
+		vector<uint32_t> m_limbs{};
+	};
+
+	static_assert(
+		[]() consteval
+		{
+			big_uint_t const x{ 0xFFFF'FFFF'FFFF'FFFF };
+			auto sq = x * x;
 
-	constexpr auto Percentages(int16_t modifier, vector<int16_t> const& dice) noexcept
+			if (sq.Bits() != 128 || sq.Mod(1000000007) != 114944269 || sq <= x)
+				return false;
+
+			sq += 1;
+			sq -= x * x;
+
+			return sq == 1 && big_uint_t{ 7 }.MulAdd(6, 5) == 47;
+		}()
+	);
+
+	// *p <<= bits, in steps MulAdd() can take.
+	constexpr void ShiftLeft(big_uint_t* p, int bits) noexcept
 	{
-		auto const iTotal = Possibilities(dice);
+		for (; bits >= 31; bits -= 31)
+			p->MulAdd(1u << 31, 0);
 
-		return
-			Distribution(modifier, LowerBound(modifier, dice), UpperBound(modifier, dice), dice)
-			| std::views::transform([&](auto&& cnt) noexcept { auto const gcd_ = Arithmatic::gcd(cnt, iTotal); return (double)(cnt / gcd_) / double(iTotal / gcd_); })
-			| std::ranges::to<vector>();
+		p->MulAdd(1u << bits, 0);
 	}
 
-	constexpr auto Expectation(int16_t modifier, vector<int16_t> const& dice) noexcept
+	// num / den, rounded only once at the very end rather than reducing the fraction bucket by bucket.
+	// Long division yields 63 bits of quotient plus a sticky bit for the remainder, so the single conversion into double rounds correctly.
+	inline double Ratio(big_uint_t num, big_uint_t den) noexcept
 	{
-		auto const E =
-			[](auto&& x) noexcept -> double
+		if (num.IsZero())
+			return 0.0;
+
+		// Align both sides so that den <= num < 2 * den.
+		auto exponent = (int)num.Bits() - (int)den.Bits();
+
+		if (exponent > 0)
+			ShiftLeft(&den, exponent);
+		else
+			ShiftLeft(&num, -exponent);
+
+		if (num < den)
+		{
+			num.MulAdd(2, 0);
+			--exponent;
+		}
+
+		uint64_t quotient = 0;
+
+		for (int i = 0; i < 63; ++i)
+		{
+			quotient <<= 1;
+
+			if (num >= den)
 			{
-				// retain the lhs, but take E(x) on the number.
+				num -= den;
+				quotient |= 1;
+			}
 
-				if (x < 0)
-					return ((double)x - 1.0) / 2.0;
+			num.MulAdd(2, 0);
+		}
 
-				return (1.0 + (double)x) / 2.0;
-			};
+		quotient = (quotient << 1) | (uint64_t)!num.IsZero();
 
-		return std::ranges::fold_left(dice | std::views::transform(E), modifier, std::plus<>{});
+		return std::ldexp((double)quotient, exponent - 63);
 	}
-
-#define TEST_DICE vector<int16_t>{ -4, 10, 10, 10 }
-	static_assert(
-		Possibilities(TEST_DICE) == 4000
-		and LowerBound(4, TEST_DICE) == 3 and UpperBound(4, TEST_DICE) == 33
-		and Confidence(/* lower_bound */3, Percentages(4, TEST_DICE)) == 7
-		and Expectation(4, TEST_DICE) == 18
-		);
-#undef TEST_DICE
 }
 
-namespace AbilityCheck
+namespace Convolution
 {
-	inline constexpr auto ADVANTAGED_FREQ =
-		[]() consteval
+	// Add one die onto a distribution in place, i.e. convolute the histogram with a uniform one of |face| buckets.
+	// Both d6 and -d6 are six consecutive outcomes of equal weight, the offset of the latter is taken care by LowerBound().
+	template <typename T>
+	constexpr void AddDie(vector<T>* prgDist, int16_t face) noexcept
+	{
+		auto& dist = *prgDist;
+		auto const width = (size_t)Arithmatic::abs(face);
+		auto const old_size = dist.size();
+
+		if (width <= 1 || old_size == 0)
+			return;
+
+		dist.resize(old_size + width - 1);
+
+		// Walking backward, so every bucket we are reading has not been overwritten yet.
+
+		if constexpr (std::floating_point<T>)
 		{
-			array<uint16_t, 21> res{};
+			// Running window subtraction cancels catastrophically in the tails of a floating point histogram.
+			// Stay with the plain sum, cost O(range * faces).
 
-			for (int16_t i = 1; i <= 20; ++i)
+			auto const weight = T(1) / (T)width;
+
+			for (auto i = dist.size(); i-- > 0;)
 			{
-				for (decltype(i) j = 1; j <= 20; ++j)
-				{
-					++res[std::max(i, j)];
-				}
+				T sum{};
+
+				for (auto k = (i + 1 > width ? i + 1 - width : 0); k <= i; ++k)
+					sum += dist[k];
+
+				dist[i] = sum * weight;
 			}
+		}
+		else
+		{
+			// Running-sum window, cost O(range).
+			// dist'[i] = dist[i - width + 1] + ... + dist[i]
 
-			return res;
+			T window{};
+
+			for (auto k = dist.size() - width; k < dist.size(); ++k)
+				window += dist[k];
+
+			for (auto i = dist.size(); i-- > 0;)
+			{
+				auto const cur = dist[i];
+				dist[i] = window;
+
+				window -= cur;
+
+				if (i >= width)
+					window += dist[i - width];
+			}
 		}
-	();
+	}
 
-	constexpr uint16_t AdvantageFrequency(int16_t val) noexcept { return 2 * std::clamp<decltype(val)>(val, 1, 20) - 1; }
+	static_assert([]() consteval { vector<int> v{ 1 }; AddDie(&v, 6); AddDie(&v, -6); return v == vector{ 1, 2, 3, 4, 5, 6, 5, 4, 3, 2, 1 }; }());
 
-	inline constexpr auto DISADVANTAGED_FREQ =
-		[]() consteval
+	// Take one die off a distribution in place, i.e. deconvolution of a uniform histogram of |face| buckets.
+	// Lossless for exact counts which did contain such a die: dist[i] = dist'[i] - dist'[i - 1] + dist[i - width]
+	template <typename T>
+	constexpr void RemoveDie(vector<T>* prgDist, int16_t face) noexcept
+	{
+		static_assert(!std::floating_point<T>, "Deconvolution amplifies the rounding error of floating point histogram.");
+
+		auto& dist = *prgDist;
+		auto const width = (size_t)Arithmatic::abs(face);
+
+		if (width <= 1 || dist.size() < width)
+			return;
+
+		auto const new_size = dist.size() - width + 1;
+		T prev{};	// dist'[i - 1]
+
+		// Walking forward, dist[i - width] is the result already.
+		for (size_t i = 0; i < new_size; ++i)
 		{
-			array<uint16_t, 21> res{};
+			T cur = dist[i];
 
-			for (int16_t i = 1; i <= 20; ++i)
+			if (i >= width)
+				cur += dist[i - width];
+
+			cur -= prev;	// never goes below zero, as dist'[i] + dist[i - width] == dist[i] + dist'[i - 1]
+			prev = std::exchange(dist[i], std::move(cur));
+		}
+
+		dist.resize(new_size);
+	}
+
+	static_assert([]() consteval { vector<int> v{ 1 }; AddDie(&v, 6); AddDie(&v, -8); AddDie(&v, 6); RemoveDie(&v, 6); RemoveDie(&v, 6); return v == vector(8, 1); }());
+
+	// In place iterative radix-2 Cooley-Tukey, size of data must be the power of 2.
+	inline void FFT(vector<std::complex<double>>* prgData, bool bInverse) noexcept
+	{
+		auto& data = *prgData;
+		auto const n = data.size();
+
+		// bit reversal permutation.
+		for (size_t i = 1, j = 0; i < n; ++i)
+		{
+			auto bit = n >> 1;
+
+			for (; j & bit; bit >>= 1)
+				j ^= bit;
+
+			j ^= bit;
+
+			if (i < j)
+				std::swap(data[i], data[j]);
+		}
+
+		// Twiddles straight from sin/cos instead of accumulated multiplications, the error would otherwise grow with the size.
+		vector<std::complex<double>> roots(n / 2);
+		for (auto&& [k, root] : std::views::enumerate(roots))
+			root = std::polar(1.0, (bInverse ? 2.0 : -2.0) * std::numbers::pi * (double)k / (double)n);
+
+		for (size_t len = 2; len <= n; len <<= 1)
+		{
+			auto const half = len / 2;
+			auto const stride = n / len;
+
+			for (size_t i = 0; i < n; i += len)
 			{
-				for (decltype(i) j = 1; j <= 20; ++j)
+				for (size_t j = 0; j < half; ++j)
 				{
-					++res[std::min(i, j)];
+					auto const u = data[i + j];
+					auto const v = data[i + j + half] * roots[j * stride];
+
+					data[i + j] = u + v;
+					data[i + j + half] = u - v;
 				}
 			}
+		}
 
-			return res;
+		if (bInverse)
+		{
+			for (auto&& z : data)
+				z /= (double)n;
 		}
-	();
+	}
 
-	constexpr uint16_t DisadvantageFrequency(int16_t val) noexcept { return AdvantageFrequency(21 - val); }
+	// Convolution of two real histograms in O(n log n).
+	// Both of them are packed into a single complex sequence a + ib, as Im((a + ib)^2) == 2ab, two transforms are all it takes.
+	inline vector<double> ConvolveFFT(vector<double> const& lhs, vector<double> const& rhs) noexcept
+	{
+		auto const size = lhs.size() + rhs.size() - 1;
+		vector<std::complex<double>> buf(std::bit_ceil(size));
+
+		for (auto&& [z, val] : std::views::zip(buf, lhs))
+			z.real(val);
+		for (auto&& [z, val] : std::views::zip(buf, rhs))
+			z.imag(val);
+
+		FFT(&buf, false);
+
+		for (auto&& z : buf)
+			z *= z;
+
+		FFT(&buf, true);
+
+		// Clamp away the tiny negative noise from the rounding, a probability never goes below zero.
+		return
+			buf
+			| std::views::take(size)
+			| std::views::transform([](auto&& z) noexcept { return std::max(z.imag() / 2.0, 0.0); })
+			| std::ranges::to<vector>();
+	}
+
+	// Plain O(m * n) convolution.
+	template <typename T>
+	constexpr vector<T> ConvolveDirect(vector<T> const& lhs, vector<T> const& rhs) noexcept
+	{
+		if (lhs.empty() || rhs.empty())
+			return {};
+
+		vector<T> ret{};
+		ret.resize(lhs.size() + rhs.size() - 1);
+
+		for (size_t i = 0; i < lhs.size(); ++i)
+		{
+			if (lhs[i] == T{})
+				continue;
+
+			if !consteval
+			{
+				if constexpr (std::same_as<T, double> || std::same_as<T, uint64_t>)
+				{
+					Kernel::MultiplyAdd(span{ ret }.subspan(i, rhs.size()), lhs[i], rhs);
+					continue;
+				}
+			}
+
+			for (size_t j = 0; j < rhs.size(); ++j)
+				ret[i + j] += lhs[i] * rhs[j];
+		}
+
+		return ret;
+	}
+
+	struct ntt_prime_t final
+	{
+		uint32_t m_prime{};
+		uint32_t m_root{};	// primitive root
+	};
+
+	inline constexpr auto NTT_MAX_LOG2 = 18;
+
+	// Every prime c * 2^18 + 1 in between 2^30 and 2^31, each one carries 30 bits of the result.
+	// Hundreds of them, enough for pools of ten thousands bits of possibilities.
+	inline vector<ntt_prime_t> const& NTTPrimes() noexcept
+	{
+		static auto const primes =
+			[]() noexcept
+			{
+				vector<ntt_prime_t> ret{};
+
+				for (uint32_t c = (1u << (30 - NTT_MAX_LOG2)) + 1; c < (1u << (31 - NTT_MAX_LOG2)); c += 2)
+				{
+					auto const p = (c << NTT_MAX_LOG2) + 1;
+
+					if (!Arithmatic::IsPrime(p))
+						continue;
+
+					// p - 1 == c * 2^18, distinct prime factors are 2 and these of c.
+					vector<uint32_t> factors{ 2 };
+
+					for (uint32_t q = 3, rest = c; rest > 1; q += 2)
+					{
+						if (q * q > rest)
+						{
+							factors.push_back(rest);
+							break;
+						}
+
+						if (rest % q == 0)
+						{
+							factors.push_back(q);
+
+							while (rest % q == 0)
+								rest /= q;
+						}
+					}
+
+					for (uint32_t g = 2; g < p; ++g)
+					{
+						if (std::ranges::none_of(factors, [&](uint32_t q) noexcept { return Arithmatic::PowMod(g, (p - 1) / q, p) == 1; }))
+						{
+							ret.emplace_back(p, g);
+							break;
+						}
+					}
+				}
+
+				return ret;
+			}();
+
+		return primes;
+	}
+
+	// In place number theoretic transform modulo a prime, size of data must be the power of 2.
+	inline void NTT(vector<uint64_t>* prgData, ntt_prime_t const& prime, bool bInverse) noexcept
+	{
+		auto& data = *prgData;
+		auto const n = data.size();
+		auto const p = (uint64_t)prime.m_prime;
+
+		for (size_t i = 1, j = 0; i < n; ++i)
+		{
+			auto bit = n >> 1;
+
+			for (; j & bit; bit >>= 1)
+				j ^= bit;
+
+			j ^= bit;
+
+			if (i < j)
+				std::swap(data[i], data[j]);
+		}
+
+		for (size_t len = 2; len <= n; len <<= 1)
+		{
+			auto const half = len / 2;
+			auto w_len = Arithmatic::PowMod(prime.m_root, (p - 1) / len, p);
+
+			if (bInverse)
+				w_len = Arithmatic::PowMod(w_len, p - 2, p);
+
+			for (size_t i = 0; i < n; i += len)
+			{
+				uint64_t w = 1;
+
+				for (size_t j = 0; j < half; ++j, w = w * w_len % p)
+				{
+					auto const u = data[i + j];
+					auto const v = data[i + j + half] * w % p;
+
+					data[i + j] = (u + v) % p;
+					data[i + j + half] = (u + p - v) % p;
+				}
+			}
+		}
+
+		if (bInverse)
+		{
+			auto const n_inv = Arithmatic::PowMod(n, p - 2, p);
+
+			for (auto&& val : data)
+				val = val * n_inv % p;
+		}
+	}
+
+	// Exact convolution of big counts: NTT modulo as many primes as the largest possible bucket requires,
+	// then Chinese remainder reconstruction (Garner's mixed radix form) back into big integers.
+	// Returns nothing if the primes or the transform length do not suffice, and the caller should go plain.
+	inline std::optional<vector<Arithmatic::big_uint_t>> ConvolveNTT(vector<Arithmatic::big_uint_t> const& lhs, vector<Arithmatic::big_uint_t> const& rhs) noexcept
+	{
+		using Arithmatic::big_uint_t;
+
+		auto const size = lhs.size() + rhs.size() - 1;
+		auto const n = std::bit_ceil(size);
+
+		// No bucket could exceed sum(lhs) * sum(rhs).
+		auto const bits =
+			std::ranges::fold_left(lhs, big_uint_t{}, std::plus<>{}).Bits()
+			+ std::ranges::fold_left(rhs, big_uint_t{}, std::plus<>{}).Bits();
+		auto const prime_count = bits / 30 + 1;
+
+		auto const& all_primes = NTTPrimes();
+
+		if (n > (1u << NTT_MAX_LOG2) || prime_count > all_primes.size())
+			return std::nullopt;
+
+		auto const primes = span{ all_primes.data(), prime_count };
+
+		vector<vector<uint32_t>> residues(prime_count);
+		vector<uint64_t> a(n), b(n);
+
+		for (auto&& [prime, res] : std::views::zip(primes, residues))
+		{
+			std::ranges::fill(a, 0);
+			std::ranges::fill(b, 0);
+
+			for (auto&& [val, big] : std::views::zip(a, lhs))
+				val = big.Mod(prime.m_prime);
+			for (auto&& [val, big] : std::views::zip(b, rhs))
+				val = big.Mod(prime.m_prime);
+
+			NTT(&a, prime, false);
+			NTT(&b, prime, false);
+
+			for (auto&& [x, y] : std::views::zip(a, b))
+				x = x * y % prime.m_prime;
+
+			NTT(&a, prime, true);
+
+			res = a
+				| std::views::take(size)
+				| std::views::transform([](uint64_t val) noexcept { return static_cast<uint32_t>(val); })
+				| std::ranges::to<vector>();
+		}
+
+		// inverses[i][j] == primes[j]^-1 mod primes[i], j < i
+		vector<vector<uint64_t>> inverses(prime_count);
+
+		for (size_t i = 0; i < prime_count; ++i)
+		{
+			for (size_t j = 0; j < i; ++j)
+				inverses[i].push_back(Arithmatic::PowMod(primes[j].m_prime, primes[i].m_prime - 2, primes[i].m_prime));
+		}
+
+		vector<big_uint_t> ret(size);
+		vector<uint64_t> digits(prime_count);
+
+		for (size_t idx = 0; idx < size; ++idx)
+		{
+			// x == d[0] + d[1] * p[0] + d[2] * p[0] * p[1] + ...
+			for (size_t i = 0; i < prime_count; ++i)
+			{
+				uint64_t const p = primes[i].m_prime;
+				uint64_t t = residues[i][idx];
+
+				for (size_t j = 0; j < i; ++j)
+					t = (t + p - digits[j] % p) % p * inverses[i][j] % p;
+
+				digits[i] = t;
+			}
+
+			auto& x = ret[idx];
+
+			for (size_t i = prime_count; i-- > 0;)
+				x.MulAdd(primes[i].m_prime, static_cast<uint32_t>(digits[i]));
+		}
+
+		return ret;
+	}
+
+	// Smaller side of the convolution must reach this many buckets before FFT pays off.
+	inline constexpr size_t FFT_THRESHOLD = 64;
+	inline constexpr size_t NTT_THRESHOLD = 32;
+
+	// Convolution of two histograms.
+	// Plain sum for small ones, FFT for large probabilities and NTT for large big counts, the latter two outside of constant evaluation only.
+	template <typename T>
+	constexpr vector<T> Convolve(vector<T> const& lhs, vector<T> const& rhs) noexcept
+	{
+		if !consteval
+		{
+			if constexpr (std::same_as<T, double>)
+			{
+				if (std::min(lhs.size(), rhs.size()) >= FFT_THRESHOLD)
+					return ConvolveFFT(lhs, rhs);
+			}
+			else if constexpr (std::same_as<T, Arithmatic::big_uint_t>)
+			{
+				if (std::min(lhs.size(), rhs.size()) >= NTT_THRESHOLD)
+				{
+					if (auto res = ConvolveNTT(lhs, rhs); res)
+						return std::move(*res);
+				}
+			}
+		}
+
+		return ConvolveDirect(lhs, rhs);
+	}
+
+	// Histogram of count copies of whatever base is the histogram of, summed up by repeated squaring.
+	template <typename T>
+	constexpr vector<T> Power(vector<T> base, size_t count) noexcept
+	{
+		vector<T> ret{ T(1) };
+
+		for (; count; count >>= 1)
+		{
+			if (count & 1)
+				ret = Convolve(ret, base);
+
+			if (count > 1)
+				base = Convolve(base, base);
+		}
+
+		return ret;
+	}
+
+	// NdX in one go: raise the histogram of a single die to the power of N.
+	template <typename T>
+	constexpr vector<T> Power(int16_t face, size_t count) noexcept
+	{
+		auto const width = (size_t)Arithmatic::abs(face);
+
+		if (width <= 1)
+			return { T(1) };
+
+		if constexpr (std::floating_point<T>)
+			return Power(vector<T>(width, T(1) / (T)width), count);
+		else
+			return Power(vector<T>(width, T(1)), count);
+	}
+
+	static_assert([]() consteval { vector<int> v{ 1 }; AddDie(&v, 6); AddDie(&v, 6); AddDie(&v, 6); return v == Power<int>(6, 3) && v == Power<int>(-6, 3); }());
+
+	// Exact histograms of 1 to 14 copies of every standard die, baked at compile time. 20^14 still fits into uint64_t.
+	// Sums of a uniform die are symmetric, so -dX shares the very same histogram with dX.
+	inline constexpr size_t MAX_TABLED_COUNT = 14;
+
+	template <int16_t FACE>
+	struct standard_table_t final
+	{
+		// n dice make n * (FACE - 1) + 1 entries, laid one after another.
+		static constexpr size_t OffsetOf(size_t count) noexcept { return (FACE - 1) * (count - 1) * count / 2 + (count - 1); }
+		static inline constexpr size_t SIZE = OffsetOf(MAX_TABLED_COUNT + 1);
+
+		constexpr span<uint64_t const> operator[] (size_t count) const noexcept { return span{ m_counts }.subspan(OffsetOf(count), count * (FACE - 1) + 1); }
+
+		array<uint64_t, SIZE> m_counts{};
+	};
+
+	template <int16_t FACE>
+	consteval standard_table_t<FACE> GenerateStandardTable() noexcept
+	{
+		standard_table_t<FACE> ret{};
+		vector<uint64_t> hist{ 1 };
+
+		for (size_t count = 1; count <= MAX_TABLED_COUNT; ++count)
+		{
+			AddDie(&hist, FACE);
+			std::ranges::copy(hist, ret.m_counts.begin() + standard_table_t<FACE>::OffsetOf(count));
+		}
+
+		return ret;
+	}
+
+	inline constexpr auto D4_TABLE = GenerateStandardTable<4>();
+	inline constexpr auto D6_TABLE = GenerateStandardTable<6>();
+	inline constexpr auto D8_TABLE = GenerateStandardTable<8>();
+	inline constexpr auto D10_TABLE = GenerateStandardTable<10>();
+	inline constexpr auto D12_TABLE = GenerateStandardTable<12>();
+	inline constexpr auto D20_TABLE = GenerateStandardTable<20>();
+
+	static_assert(
+		std::ranges::equal(D6_TABLE[1], array<uint64_t, 6>{ 1, 1, 1, 1, 1, 1 })
+		and std::ranges::equal(D6_TABLE[2], array<uint64_t, 11>{ 1, 2, 3, 4, 5, 6, 5, 4, 3, 2, 1 })
+		and D20_TABLE[MAX_TABLED_COUNT].size() == 19 * MAX_TABLED_COUNT + 1
+		and std::ranges::fold_left(D20_TABLE[MAX_TABLED_COUNT], 0ull, std::plus<>{}) == 1'638'400'000'000'000'000ull
+	);
+
+	// Empty if not in the tables.
+	constexpr span<uint64_t const> StandardHistogram(int16_t face, size_t count) noexcept
+	{
+		if (count < 1 || count > MAX_TABLED_COUNT)
+			return {};
+
+		switch (Arithmatic::abs(face))
+		{
+		case 4:
+			return D4_TABLE[count];
+		case 6:
+			return D6_TABLE[count];
+		case 8:
+			return D8_TABLE[count];
+		case 10:
+			return D10_TABLE[count];
+		case 12:
+			return D12_TABLE[count];
+		case 20:
+			return D20_TABLE[count];
+
+		default:
+			return {};
+		}
+	}
+
+	// Histogram of a whole pool, index 0 being its lower bound.
+	// After Dice::Sort(), identical dice are neighbours, so each run is looked up or done by Power(), and then merged into the pool.
+	template <typename T>
+	constexpr vector<T> Pool(vector<int16_t> const& dice) noexcept
+	{
+		vector<T> ret{ T(1) };	// no dice: one way to roll the modifier.
+
+		for (auto&& run : dice | std::views::chunk_by(std::ranges::equal_to{}))
+		{
+			auto const count = std::ranges::size(run);
+
+			// Standard dice come right out of the tables, and seed the rest of the pool.
+			if (auto const hist = StandardHistogram(run.front(), count); !hist.empty())
+			{
+				vector<T> seed{};
+
+				if constexpr (std::floating_point<T>)
+				{
+					// Powers of 4, 6, 8, 10, 12 and 20 up to the 14th are exact in double.
+					auto const total = std::ranges::fold_left(std::views::repeat((T)Arithmatic::abs(run.front()), count), T(1), std::multiplies<>{});
+					seed = hist | std::views::transform([&](uint64_t cnt) noexcept { return (T)cnt / total; }) | std::ranges::to<vector>();
+				}
+				else
+					seed = hist | std::views::transform([](uint64_t cnt) noexcept { return T(cnt); }) | std::ranges::to<vector>();
+
+				ret = Convolve(ret, seed);
+			}
+			else if (count == 1)
+				AddDie(&ret, run.front());
+			else
+				ret = Convolve(ret, Power<T>(run.front(), count));
+		}
+
+		return ret;
+	}
+}
+
+namespace Statistics
+{
+	constexpr int16_t Confidence(int32_t minimum, vector<double> const& rgflPercentages) noexcept
+	{
+		if !consteval
+		{
+			auto const idx = Kernel::FindFirstGreater(rgflPercentages, 0.005);
+			return idx < rgflPercentages.size() ? (int16_t)(minimum + (int32_t)idx) : (int16_t)-1;
+		}
+
+		for (auto&& [iDamage, flChance] : std::views::zip(std::views::iota(minimum), rgflPercentages))
+		{
+			if (flChance > 0.005)	// Greater than 0.5%
+				return (int16_t)iDamage;
+		}
+
+		return (int16_t)-1;
+	}
+
+	constexpr int16_t Confidence(int32_t minimum, vector<double> const& rgflPercentages, double flChance) noexcept
+	{
+		auto tmp = 1.0 - flChance;
+
+		for (auto&& [iDamage, flChance] : std::views::zip(std::views::iota(minimum), rgflPercentages))
+		{
+			tmp -= flChance;
+
+			if (tmp <= 0)
+				return (int16_t)iDamage;
+		}
+
+		return (int16_t)-1;
+	}
+
+	constexpr auto IntervalEstimate(vector<double> const& rgflPercentages, int16_t iLeftBound, int16_t iRightBound, double flStdDev) noexcept
+	{
+		auto tmp{ 1.0 };
+
+		for (auto&& [iDamage, flChance] : std::views::zip(std::views::iota(iLeftBound), rgflPercentages))
+		{
+			tmp -= 2 * flChance;	// symmetric
+
+			if (tmp < flStdDev)
+				break;
+
+			++iLeftBound;
+			--iRightBound;
+
+			if (iLeftBound > iRightBound)
+				break;	// ERROR!
+		}
+
+		return pair{ iLeftBound, iRightBound };
+	}
+
+	constexpr auto Challenge(int16_t minimum, vector<double> const& rgflPercentages, int16_t dc) noexcept
+	{
+		if !consteval
+		{
+			return Kernel::Sum(span{ rgflPercentages }.subspan(std::min<size_t>(std::max(dc - minimum, 0), rgflPercentages.size())));
+		}
+
+		double pass{};
+
+		for (auto&& [iResult, flChance] : std::views::zip(std::views::iota(minimum), rgflPercentages))
+		{
+			if (iResult < dc)
+				continue;
+
+			pass += flChance;
+		}
+
+		return pass;
+	}
+
+	constexpr auto ChallengeEx(int32_t minimum, vector<double> const& rgflPercentages, int16_t dc) noexcept
+	{
+		double pass{};
+
+		if !consteval
+		{
+			pass = Kernel::Sum(span{ rgflPercentages }.subspan(std::min<size_t>(std::max(dc - minimum, 0), rgflPercentages.size())));
+		}
+		else
+		{
+			for (auto&& [iResult, flChance] : std::views::zip(std::views::iota(minimum), rgflPercentages))
+			{
+				if (iResult < dc)
+					continue;
+
+				pass += flChance;
+			}
+		}
+
+		auto const fail = 1.0 - pass;
+		auto const pass_when_adv = 1.0 - fail * fail;
+		auto const pass_when_disadv = pass * pass;
+
+		return tuple{
+			pass,
+			pass_when_adv,
+			pass_when_disadv,
+		};
+	}
+
+	// Percentages along with their cumulative sums from both ends.
+	// Challenge() becomes O(1), Confidence() and IntervalEstimate() O(log n) by binary search on the monotonic sums.
+	struct cdf_t final
+	{
+		constexpr cdf_t() noexcept = default;
+		constexpr cdf_t(int32_t minimum, span<double const> rgflPercentages) noexcept { Assign(minimum, rgflPercentages); }
+
+		// Capacity of the sums is kept, so a worker could reuse one cdf_t for all of its pools.
+		constexpr void Assign(int32_t minimum, span<double const> rgflPercentages) noexcept
+		{
+			m_minimum = minimum;
+			m_maximum = minimum + (int32_t)rgflPercentages.size() - 1;
+			m_first_notable = -1;
+
+			m_at_most.resize(rgflPercentages.size());
+			m_at_least.assign(rgflPercentages.size() + 1, 0.0);
+
+			if !consteval
+			{
+				Kernel::PrefixSum(rgflPercentages, m_at_most);
+				Kernel::SuffixSum(rgflPercentages, m_at_least);
+
+				if (auto const idx = Kernel::FindFirstGreater(rgflPercentages, 0.005); idx < rgflPercentages.size())
+					m_first_notable = (int16_t)(minimum + (int32_t)idx);
+
+				return;
+			}
+
+			double sum{};
+
+			for (auto&& [flSum, flChance] : std::views::zip(m_at_most, rgflPercentages))
+				flSum = (sum += flChance);
+
+			// Sum up the tail from its far end, small chances won't be swallowed by large ones.
+			sum = 0;
+
+			for (auto i = rgflPercentages.size(); i-- > 0;)
+				m_at_least[i] = (sum += rgflPercentages[i]);
+
+			if (auto const it = std::ranges::find_if(rgflPercentages, [](double flChance) noexcept { return flChance > 0.005; }); it != rgflPercentages.end())
+				m_first_notable = (int16_t)(minimum + (it - rgflPercentages.begin()));
+		}
+
+		// P(X >= dc)
+		constexpr double Challenge(int32_t dc) const noexcept
+		{
+			// Nothing assigned yet, and std::clamp() must not see hi < lo.
+			if (m_at_least.empty())
+				return 0;
+
+			return m_at_least[std::clamp<int32_t>(dc - m_minimum, 0, (int32_t)m_at_least.size() - 1)];
+		}
+
+		constexpr auto Challenge(span<int32_t const> rgiDCs) const noexcept
+		{
+			return
+				rgiDCs
+				| std::views::transform([this](int32_t dc) noexcept { return Challenge(dc); })
+				| std::ranges::to<vector>();
+		}
+
+		// Same as Statistics::Confidence(), the first result with greater than 0.5% of chance.
+		constexpr int16_t Confidence() const noexcept { return m_first_notable; }
+
+		// Same as Statistics::Confidence(), the lowest result x such that P(X <= x) >= 1 - flChance.
+		constexpr int16_t Confidence(double flChance) const noexcept
+		{
+			auto const it = std::ranges::lower_bound(m_at_most, 1.0 - flChance);
+
+			if (it == m_at_most.end())
+				return (int16_t)-1;
+
+			return (int16_t)(m_minimum + (it - m_at_most.begin()));
+		}
+
+		// Sums off by a few ULP must not miss a target hit right on, say 65% of d20 >= 8.
+		static inline constexpr double TARGET_SLACK = 1e-12;
+
+		// The highest DC passed with at least flChance, the inverse of Challenge(). nullopt if none is.
+		constexpr std::optional<int32_t> HighestDC(double flChance) const noexcept
+		{
+			auto const idx = std::ranges::partition_point(m_at_least, [&](double flPass) noexcept { return flPass >= flChance - TARGET_SLACK; }) - m_at_least.begin();
+
+			if (idx == 0)
+				return std::nullopt;
+
+			return m_minimum + (int32_t)idx - 1;
+		}
+
+		constexpr auto Confidence(span<double const> rgflChances) const noexcept
+		{
+			return
+				rgflChances
+				| std::views::transform([this](double flChance) noexcept { return Confidence(flChance); })
+				| std::ranges::to<vector>();
+		}
+
+		// Same as Statistics::IntervalEstimate(), peeling both tails symmetrically until less than flStdDev remains in between.
+		constexpr pair<int16_t, int16_t> IntervalEstimate(double flStdDev) const noexcept
+		{
+			// Peeling stops at the first k such that 1 - 2 * P(X <= min + k) < flStdDev,
+			auto const by_chance = std::ranges::upper_bound(m_at_most, (1.0 - flStdDev) / 2.0) - m_at_most.begin();
+
+			// or right after both bounds passed each other.
+			auto const by_crossing = (m_maximum - m_minimum) / 2;
+
+			auto const k = by_chance <= by_crossing ? (int32_t)by_chance : by_crossing + 1;
+
+			return { (int16_t)(m_minimum + k), (int16_t)(m_maximum - k) };
+		}
+
+		int32_t m_minimum{};
+		int32_t m_maximum{};
+		int16_t m_first_notable{ -1 };
+		vector<double> m_at_most{};		// P(X <= minimum + i)
+		vector<double> m_at_least{};	// P(X >= minimum + i), plus a zero at the end.
+	};
+
+	// Wraps around silently beyond 64 bits, check CountFits() first or go ExactPossibilities().
+	constexpr auto Possibilities(vector<int16_t> const& dice) noexcept
+	{
+		return std::ranges::fold_left(
+			dice | std::views::transform([](int16_t n) noexcept -> uint64_t { return n < 0 ? -n : n; }),	// promote!
+			1,
+			std::multiplies<>{}
+		);
+	}
+
+	// Would the count of every outcome fit into uint64_t?
+	constexpr bool CountFits(vector<int16_t> const& dice) noexcept
+	{
+		uint64_t total = 1;
+
+		for (auto&& face : dice)
+		{
+			auto const width = (uint64_t)Arithmatic::abs(face);
+
+			if (width != 0 && total > std::numeric_limits<uint64_t>::max() / width)
+				return false;
+
+			total *= width;
+		}
+
+		return true;
+	}
+
+	constexpr auto ExactPossibilities(vector<int16_t> const& dice) noexcept
+	{
+		Arithmatic::big_uint_t ret{ 1 };
+
+		for (auto&& face : dice)
+			ret.MulAdd(Arithmatic::abs(face), 0);
+
+		return ret;
+	}
+
+	// LowerBound() and UpperBound() are both int16_t, make sure nothing wraps before trusting them.
+	// Leaves the room for a d20 as well, AbilityCheck is built on top of them.
+	constexpr bool RangeFits(int16_t modifier, vector<int16_t> const& dice) noexcept
+	{
+		int32_t lower_bound{ modifier }, upper_bound{ modifier };
+
+		for (auto&& face : dice)
+		{
+			lower_bound += face < 0 ? face : 1;
+			upper_bound += face < 0 ? -1 : face;
+		}
+
+		return lower_bound >= std::numeric_limits<int16_t>::min() && upper_bound + 20 <= std::numeric_limits<int16_t>::max();
+	}
+
+	constexpr auto LowerBound(int16_t modifier, vector<int16_t> const& dice) noexcept
+	{
+		auto const fn =
+			[](int16_t n) noexcept -> int16_t
+			{
+				// lowest: substraction die takes its maximum and others take minimum.
+				return n < 0 ? n : 1;
+			};
+
+		// force the return type to be int16_t rather than promoted int32_t.
+		return std::ranges::fold_left(dice | std::views::transform(fn), modifier, std::plus<int16_t>{});
+	}
+
+	constexpr auto UpperBound(int16_t modifier, vector<int16_t> const& dice) noexcept
+	{
+		auto const fn =
+			[](int16_t n) noexcept -> int16_t
+			{
+				// highest: substraction die takes its minimum and others take maximum.
+				return n < 0 ? -1 : n;
+			};
+
+		// force the return type to be int16_t rather than promoted int32_t.
+		return std::ranges::fold_left(dice | std::views::transform(fn), modifier, std::plus<int16_t>{});
+	}
+
+	constexpr auto Range(int16_t modifier, vector<int16_t> const& dice) noexcept { return pair{ LowerBound(modifier, dice), UpperBound(modifier, dice) }; }
+
+	constexpr auto Distribution([[maybe_unused]] int16_t modifier, [[maybe_unused]] int16_t lower_bound, [[maybe_unused]] int16_t upper_bound, vector<int16_t> const& dice) noexcept
+	{
+		// Build the histogram by convolution instead of walking every outcome.
+		// The very first bucket is always the lower bound, hence the modifier is merely a shift.
+
+		return Convolution::Pool<uint64_t>(dice);
+	}
+
+	// Pools whose counts fit into uint64_t are counted exactly and divided once, every bucket stays within PROBABILITY_ULPS of its own ULP.
+	// Larger ones have their probabilities convoluted as they are, no count array in between and no pass of division afterward.
+	// Rounding piles up with every convolution there and FFT spreads it over the whole histogram, so the bound is PROBABILITY_ULPS of ULP(1.0), absolute.
+	// Against its own ULP a far tail strays further, e.g. 16d10 through the same pipeline comes out 12 ULPs off.
+	// Tails below DBL_MIN merely underflow to zero, far beneath anything Confidence() or the printout could tell apart.
+	// Whoever needs the exact rationals keeps the big counts, as dice_pool_t does.
+	inline constexpr double PROBABILITY_ULPS = 8;
+
+	// Exact count mode, no matter how large the pool is.
+	constexpr auto ExactDistribution(vector<int16_t> const& dice) noexcept { return Convolution::Pool<Arithmatic::big_uint_t>(dice); }
+
+	// Farthest a bucket strays from its exact rational, in ULP(1.0). Slow, the whole pool is counted exactly for it.
+	inline double DeviationOf(vector<int16_t> const& dice, span<double const> rgflPercentages) noexcept
+	{
+		auto const total = ExactPossibilities(dice);
+		auto const counts = ExactDistribution(dice);
+		double ret{};
+
+		for (auto&& [iOffset, cnt] : std::views::enumerate(counts))
+			ret = std::max(ret, Arithmatic::abs(rgflPercentages[iOffset] - Arithmatic::Ratio(cnt, total)));
+
+		return ret / std::numeric_limits<double>::epsilon();
+	}
+
+	// The static_assert below never reaches FFT, so debug builds hold every pool off the floating point path to the bound at run time.
+	inline void VerifyPercentages([[maybe_unused]] vector<int16_t> const& dice, [[maybe_unused]] span<double const> rgflPercentages) noexcept
+	{
+#ifdef _DEBUG
+		if (DeviationOf(dice, rgflPercentages) > PROBABILITY_ULPS)
+		{
+			std::print(stderr, u8"內部錯誤：機率誤差超出PROBABILITY_ULPS。\n");
+			std::abort();
+		}
+#endif
+	}
+
+	// Exact counts of the pool into probabilities, one division each.
+	constexpr vector<double> Normalize(vector<uint64_t> const& rgiCounts, vector<int16_t> const& dice) noexcept
+	{
+		auto const total = (double)Possibilities(dice);
+
+		return
+			rgiCounts
+			| std::views::transform([total](uint64_t cnt) noexcept { return (double)cnt / total; })
+			| std::ranges::to<vector>();
+	}
+
+	constexpr vector<double> Percentages([[maybe_unused]] int16_t modifier, vector<int16_t> const& dice) noexcept
+	{
+		if (CountFits(dice))
+			return Normalize(Distribution(modifier, 0, 0, dice), dice);
+
+		auto ret = Convolution::Pool<double>(dice);
+
+		if !consteval
+		{
+			VerifyPercentages(dice, ret);
+		}
+
+		return ret;
+	}
+
+	constexpr auto Expectation(int16_t modifier, vector<int16_t> const& dice) noexcept
+	{
+		auto const E =
+			[](auto&& x) noexcept -> double
+			{
+				// retain the lhs, but take E(x) on the number.
+
+				if (x < 0)
+					return ((double)x - 1.0) / 2.0;
+
+				return (1.0 + (double)x) / 2.0;
+			};
+
+		return std::ranges::fold_left(dice | std::views::transform(E), modifier, std::plus<>{});
+	}
+
+#define TEST_DICE vector<int16_t>{ -4, 10, 10, 10 }
+	static_assert(
+		Possibilities(TEST_DICE) == 4000
+		and LowerBound(4, TEST_DICE) == 3 and UpperBound(4, TEST_DICE) == 33
+		and Confidence(/* lower_bound */3, Percentages(4, TEST_DICE)) == 7
+		and Expectation(4, TEST_DICE) == 18
+		and ExactPossibilities(TEST_DICE) == 4000
+		and std::ranges::equal(ExactDistribution(TEST_DICE), Distribution(4, 3, 33, TEST_DICE), {}, {}, [](uint64_t n) noexcept { return Arithmatic::big_uint_t{ n }; })
+		and RangeFits(4, TEST_DICE) and !RangeFits(0, vector<int16_t>(1700, 20))
+		);
+
+	static_assert(
+		[]() consteval
+		{
+			auto const percentages = Percentages(4, TEST_DICE);
+			cdf_t const cdf{ 3, percentages };
+
+			for (auto dc = 0; dc < 40; ++dc)
+			{
+				if (Arithmatic::abs(cdf.Challenge(dc) - Challenge(3, percentages, (int16_t)dc)) > 1e-12)
+					return false;
+			}
+
+			for (auto flChance : { 0.5, 0.7, 0.8, 0.9, 0.99 })
+			{
+				if (cdf.Confidence(flChance) != Confidence(3, percentages, flChance))
+					return false;
+			}
+
+			for (auto flStdDev : { 0.682689492137, 0.954499736104, 0.997300203937 })
+			{
+				if (cdf.IntervalEstimate(flStdDev) != IntervalEstimate(percentages, 3, 33, flStdDev))
+					return false;
+			}
+
+			// Every probe of the search is a Challenge() of its own.
+			for (auto flChance : { 0.01, 0.5, 0.65, 0.9, 1.0 })
+			{
+				auto dc = 40;
+
+				while (dc >= 0 && cdf.Challenge(dc) < flChance - cdf_t::TARGET_SLACK)
+					--dc;
+
+				if (cdf.HighestDC(flChance) != dc)
+					return false;
+			}
+
+			return cdf.Confidence() == Confidence(3, percentages) && !cdf.HighestDC(1.5)
+				&& cdf_t{ 1, vector(20, 1.0 / 20.0) }.HighestDC(0.65) == 8 && cdf_t{}.Challenge(10) == 0;
+		}()
+	);
+
+	// Percentages() counts these exactly, so the floating point pipeline is run on its own against the exact ratios.
+	// Odd faces and runs past MAX_TABLED_COUNT are convoluted in double, FFT is left to Bench::Run().
+	// Same absolute bound as any pool past 64 bits is held to.
+	static_assert(
+		[]() consteval
+		{
+			for (auto&& dice : { TEST_DICE, vector<int16_t>{ 20, 12, 12, 7, 6, -4, -4 }, vector<int16_t>(9, 3), vector<int16_t>(19, 10) })
+			{
+				auto const total = (double)Possibilities(dice);
+				auto const percentages = Convolution::Pool<double>(dice);
+				auto const counts = Distribution(0, 0, 0, dice);
+
+				for (auto&& [flChance, cnt] : std::views::zip(percentages, counts))
+				{
+					auto const exact = (double)cnt / total;
+
+					if (Arithmatic::abs(flChance - exact) > PROBABILITY_ULPS * std::numeric_limits<double>::epsilon())
+						return false;
+				}
+			}
+
+			return true;
+		}()
+	);
+#undef TEST_DICE
+}
+
+namespace AbilityCheck
+{
+	inline constexpr auto ADVANTAGED_FREQ =
+		[]() consteval
+		{
+			array<uint16_t, 21> res{};
+
+			for (int16_t i = 1; i <= 20; ++i)
+			{
+				for (decltype(i) j = 1; j <= 20; ++j)
+				{
+					++res[std::max(i, j)];
+				}
+			}
+
+			return res;
+		}
+	();
+
+	constexpr uint16_t AdvantageFrequency(int16_t val) noexcept { return 2 * std::clamp<decltype(val)>(val, 1, 20) - 1; }
+
+	inline constexpr auto DISADVANTAGED_FREQ =
+		[]() consteval
+		{
+			array<uint16_t, 21> res{};
+
+			for (int16_t i = 1; i <= 20; ++i)
+			{
+				for (decltype(i) j = 1; j <= 20; ++j)
+				{
+					++res[std::min(i, j)];
+				}
+			}
+
+			return res;
+		}
+	();
+
+	constexpr uint16_t DisadvantageFrequency(int16_t val) noexcept { return AdvantageFrequency(21 - val); }
+
+	inline constexpr auto TWO_D20_RES_COUNT = std::ranges::fold_left(ADVANTAGED_FREQ, 0, std::plus<std::ranges::range_value_t<decltype(ADVANTAGED_FREQ)>>{});
+	static_assert(TWO_D20_RES_COUNT == 400, "Simple math, 20 * 20 == 400");
+
+	inline constexpr auto MAX_D20_COUNT = 14;	// 20^14 still fits into uint64_t
+
+	// Distribution of the rank-th lowest d20 out of count, index 0 being the face 1.
+	// Keep highest of two is the advantage, keep lowest of two the disadvantage, keep highest of three the Elven Accuracy.
+	// P(X <= v) == sum{ C(n, m) * v^m * (20 - v)^(n - m), m = rank...n } / 20^n, i.e. at least rank of them rolled v or less.
+	constexpr auto OrderStatistic(int16_t count, int16_t rank) noexcept
+	{
+		count = std::clamp<int16_t>(count, 1, MAX_D20_COUNT);
+		rank = std::clamp<int16_t>(rank, 1, count);
+
+		auto const fnPower = [](uint64_t base, int16_t exp) noexcept { uint64_t ret = 1; while (exp-- > 0) ret *= base; return ret; };
+		auto const fnBinomial = [](uint64_t n, uint64_t k) noexcept { uint64_t ret = 1; for (uint64_t i = 1; i <= k; ++i) ret = ret * (n - k + i) / i; return ret; };
+
+		// No term could exceed their sum, which is (v + 20 - v)^n.
+		auto const fnAtMost =
+			[&](int16_t v) noexcept
+			{
+				uint64_t ret = 0;
+
+				for (auto m = rank; m <= count; ++m)
+					ret += fnBinomial(count, m) * fnPower(v, m) * fnPower(20 - v, count - m);
+
+				return ret;
+			};
+
+		auto const total = (double)fnPower(20, count);
+		array<double, 20> ret{};
+
+		for (int16_t v = 1; v <= 20; ++v)
+			ret[v - 1] = (double)(fnAtMost(v) - fnAtMost(v - 1)) / total;
+
+		return ret;
+	}
+
+	inline constexpr auto NORMAL_D20 = OrderStatistic(1, 1);
+	inline constexpr auto ADVANTAGED_D20 = OrderStatistic(2, 2);
+	inline constexpr auto DISADVANTAGED_D20 = OrderStatistic(2, 1);
+	inline constexpr auto ELVEN_ACCURACY_D20 = OrderStatistic(3, 3);
+
+	static_assert(
+		std::ranges::all_of(std::views::iota(1, 21), [](int16_t v) noexcept { return ADVANTAGED_D20[v - 1] == ADVANTAGED_FREQ[v] / 400.0 && DISADVANTAGED_D20[v - 1] == DISADVANTAGED_FREQ[v] / 400.0 && NORMAL_D20[v - 1] == 1 / 20.0; })
+		and ELVEN_ACCURACY_D20[0] == 1 / 8000.0 and ELVEN_ACCURACY_D20[19] == (8000 - 6859) / 8000.0
+	);
+
+	// Bonus dice are rolled only once, and then convoluted with each of the d20 tables.
+	template <size_t N>
+	constexpr auto Percentages(int16_t modifier, vector<int16_t> const& dice, array<array<double, 20>, N> const& rgD20s) noexcept
+	{
+		auto const bonus = Statistics::Percentages(modifier, dice);
+		array<vector<double>, N> ret{};
+
+		for (auto&& [res, d20] : std::views::zip(ret, rgD20s))
+			res = Convolution::Convolve(bonus, vector(d20.begin(), d20.end()));
+
+		return ret;
+	}
+
+	constexpr auto Percentages(int16_t modifier, vector<int16_t> const& dice, array<double, 20> const& d20) noexcept
+	{
+		return std::move(Percentages(modifier, dice, array<array<double, 20>, 1>{ d20 })[0]);
+	}
+}
+
+namespace Dice
+{
+	struct Arrange final
+	{
+		/*#UPDATE_AT_CPP23_static_operator*/ constexpr bool operator() (int16_t lhs, int16_t rhs) const noexcept
+		{
+			/*
+			purpose:
+				replacement of std::less when dice involved.
+				positive dice always goes first, and negative dice follows.
+				e.g.
+					d4 d4 d6 d10 -d4 -d8
+			*/
+
+			auto const bLhsPositive = lhs > 0;
+			auto const bRhsPositive = rhs > 0;
+
+			if (bLhsPositive && bRhsPositive)
+				return lhs < rhs;	// d4 < d6
+
+			if (bLhsPositive && !bRhsPositive)
+				return true;	// d4 < -d4
+
+			if (!bLhsPositive && bRhsPositive)
+				return false;	// -d4 > d4
+
+			if (!bLhsPositive && !bRhsPositive)
+				return lhs > rhs;	// -d4 < -d6, but methmatically -4 is greater than -6, so...
+
+			std::unreachable();
+		}
+	};
+
+	constexpr void Sort(vector<int16_t>* prgiDice) noexcept { std::ranges::sort(*prgiDice, Arrange{}); }
+
+	constexpr auto Count(vector<int16_t> const& dice, int16_t face) noexcept { return std::ranges::count(dice, face); }
+
+	string ToString(int16_t modifier, vector<int16_t> const& dice) noexcept
+	{
+		static constexpr std::array POS_DIE_TYPES{ 4, 6, 8, 10, 12, 20, };
+		static constexpr std::array NEG_DIE_TYPES{ -4, -6, -8, -10, -12, -20, };	// #UPDATE_AT_CPP26_static_in_constexpr_fn
+
+		string ret{};
+
+		// normal dice first, then debuffs.
+		// hide '1' from 1d4.
+
+		for (auto&& type : POS_DIE_TYPES)
+			if (auto const count = Count(dice, type); count > 0)
+				ret += std::format("{}d{}", count == 1 ? "+"s : std::format("{:+}", count), type);
+
+		for (auto&& type : NEG_DIE_TYPES)
+			if (auto const count = Count(dice, type); count > 0)
+				ret += std::format("{}d{}", count == 1 ? "-"s : std::format("{}", -count), -type);
+
+		if (modifier)
+			ret += std::format("{:+}", modifier);
+
+		if (!ret.empty() && ret.front() == '+')
+			ret.erase(ret.begin());
+
+		for (auto it = ret.begin(); it != ret.end(); ++it)
+		{
+			if ("^*/%+-"sv.contains(*it))
+			{
+				it = ret.insert(it, ' ');
+				it += 2;
+				it = ret.insert(it, ' ');
+				// now iter points to the inserted space, not the operator.
+			}
+		}
+
+		return ret;
+	}
+
+	// Turns input like "2d8 + 4d6 + 5" into the modifier and sorted dice, or tells why not.
+	std::expected<pair<int16_t, vector<int16_t>>, string> Parse(string szInput) noexcept
+	{
+		for (auto&& c : szInput)
+		{
+			if (c == 'D')
+				c = 'd';
+
+			if (!"1234567890d+- "sv.contains(c))
+				return std::unexpected(std::format(u8"無效輸入：字元'{}'無法解讀\n", c));
+		}
+
+		static constexpr string_view delimiters = "+-"sv;
+		string_view const input_view{ szInput };	// make sure sz.substr() is returning string_view.
+		vector<string_view> identifiers{};
+		bool phase = false;
+
+		for (size_t pos = input_view.find_first_of(delimiters), last_pos = 0;
+			pos != input_view.npos || last_pos != input_view.npos;
+			phase = !phase, last_pos = pos, pos = (phase ? input_view.find_first_not_of(delimiters, pos) : input_view.find_first_of(delimiters, pos))
+			)
+		{
+			if (auto const trimmed = UTIL_Trim(input_view.substr(last_pos, pos - last_pos)); trimmed.length())
+			{
+				if (phase)	// split operators.
+				{
+					for (auto& c : trimmed)
+						identifiers.emplace_back(&c, 1);
+				}
+				else
+					identifiers.emplace_back(trimmed);
+			}
+		}
+
+		vector<int16_t> dice{};
+		int16_t modifier = 0;
+		bool negative = false;
+		phase = false;
+
+		for (auto&& token : identifiers)
+		{
+			// non-token?
+			if (token.length() > 1 || !delimiters.contains(token[0]))
+			{
+				// enforce the syntax.
+				if (phase)
+					return std::unexpected(std::format(u8"格式錯誤：「運算子」應與「骰子」交替。\n\t錯誤位於'{}'處。\n", token));
+				else if (std::ranges::count(token, 'd') > 1)
+					return std::unexpected(std::format(u8"格式錯誤：未指明骰子面數。\n\t錯誤位於'{}'處。\n", token));
+
+				// Is die?
+				if (auto const pos = token.find('d'); pos != token.npos)
+				{
+					auto const face = UTIL_StrToNum<int16_t>(token.substr(pos + 1)) * (int16_t)(negative ? -1 : 1);
+
+					// multiple dice
+					if (pos != 0)
+					{
+						dice.append_range(
+							std::views::repeat(
+								face,
+								UTIL_StrToNum<int16_t>(token.substr(0, pos))	// how many?
+							)
+						);
+					}
+
+					// only one.
+					else
+						dice.push_back(face);
+				}
+
+				// Or modifier?
+				else
+					modifier += UTIL_StrToNum<int16_t>(token) * (negative ? -1 : 1);
+			}
+
+			// operators?
+			else if (delimiters.contains(token[0]))
+			{
+				// enforce the syntax.
+				if (!phase)
+					return std::unexpected(std::format(u8"格式錯誤：「運算子」應與「骰子」交替。\n\t錯誤位於'{}'處。\n", token));
+
+				negative = token[0] == '-';
+			}
+
+			else
+				return std::unexpected(std::format(u8"無效輸入：不支援的運算子'{}'\n", token));
+
+			phase = !phase;
+		}
+
+		if (!Statistics::RangeFits(modifier, dice))
+			return std::unexpected(std::format(u8"無效輸入：結果超出可分析範圍[{}, {}]。\n", std::numeric_limits<int16_t>::min(), std::numeric_limits<int16_t>::max() - 20));
+
+		Sort(&dice);
+		return pair{ modifier, std::move(dice) };
+	}
+}
+
+namespace PoolCache
+{
+	// FNV-1a
+	struct hash_t final
+	{
+		/*#UPDATE_AT_CPP23_static_operator*/ size_t operator() (vector<int16_t> const& dice) const noexcept
+		{
+			uint64_t ret = 0xCBF2'9CE4'8422'2325;
+
+			for (auto&& face : dice)
+			{
+				ret ^= static_cast<uint16_t>(face);
+				ret *= 0x0000'0100'0000'01B3;
+			}
+
+			return static_cast<size_t>(ret);
+		}
+	};
+
+	struct entry_t final
+	{
+		vector<uint64_t> m_counts{};	// empty if the counts did not fit into 64 bits.
+		vector<double> m_percentages{};
+	};
+
+	inline auto& Instance() noexcept
+	{
+		static sharded_cache_t<vector<int16_t>, entry_t, hash_t> cache{ 4096 };
+		return cache;
+	}
+
+	// Set by --store=<path> before anything is rolled. Left empty, nothing ever touches the disk.
+	inline std::filesystem::path& StorePath() noexcept
+	{
+		static std::filesystem::path path{};
+		return path;
+	}
+
+	// Shared by every run and every process pointed to the same file. nullptr unless opted in.
+	inline distribution_store_t* Store() noexcept
+	{
+		static auto const pStore = StorePath().empty() ? nullptr : std::make_unique<distribution_store_t>(StorePath());
+		return pStore.get();
+	}
+
+	// Sorted pool as (face, count) pairs, e.g. 3d6 + 2d8 makes { 8, 2, 6, 3 }. Standard dice fit into as little as dice_t does.
+	inline vector<int16_t> SignatureOf(vector<int16_t> const& dice) noexcept
+	{
+		vector<int16_t> ret{};
+
+		for (auto&& run : dice | std::views::chunk_by(std::ranges::equal_to{}))
+		{
+			ret.push_back(run.front());
+			ret.push_back((int16_t)std::ranges::size(run));
+		}
+
+		return ret;
+	}
+
+	// Statistics::Percentages() memorized. The sorted pool alone makes the key, as the modifier merely shifts the histogram.
+	// A miss still starts from the longest cached prefix of the sorted pool, i.e. 6d6 + 1d8 costs one convolution after 6d6.
+	// Counts go on from the counts of the prefix, probabilities from its probabilities.
+	inline std::shared_ptr<vector<double> const> Percentages(vector<int16_t> dice) noexcept
+	{
+		Dice::Sort(&dice);
+		auto& cache = Instance();
+
+		if (auto const hit = cache.Find(dice); hit)
+			return { hit, &hit->m_percentages };
+
+		// Computed by an earlier run, or by another process.
+		auto const signature = SignatureOf(dice);
+		auto const signature_hash = (uint64_t)hash_t{}(signature);
+
+		auto const pStore = Store();
+		std::shared_ptr<entry_t const> found{};
+
+		if (pStore)
+		{
+			pStore->Find(
+				signature, signature_hash,
+				[&](distribution_store_t::view_t const& view) noexcept
+				{
+					found = std::make_shared<entry_t const>(vector(view.m_counts.begin(), view.m_counts.end()), vector(view.m_percentages.begin(), view.m_percentages.end()));
+				}
+			);
+		}
+
+		if (found)
+		{
+			auto const kept = cache.Insert(std::move(dice), std::move(found));
+			return { kept, &kept->m_percentages };
+		}
+
+		// Same probability domain as Statistics::Percentages(), exact counts whenever they fit.
+		auto const bExact = Statistics::CountFits(dice);
+		std::shared_ptr<entry_t const> prefix{};
+		size_t prefix_len = 0;
+
+		// Prefixes cut at run boundaries only, longest first. An exact pool needs the counts of its prefix, which a store record of old may lack.
+		for (auto len = dice.size() - 1; len > 0 && len < dice.size() && !prefix; --len)
+		{
+			if (dice[len - 1] == dice[len])
+				continue;
+
+			if (auto const candidate = cache.Peek(vector(dice.begin(), dice.begin() + len)); candidate && (!bExact || !candidate->m_counts.empty()))
+			{
+				prefix = candidate;
+				prefix_len = len;
+			}
+		}
+
+		vector const rest(dice.begin() + prefix_len, dice.end());
+		entry_t entry{};
+
+		if (bExact)
+		{
+			entry.m_counts = prefix ? Convolution::Convolve(prefix->m_counts, Convolution::Pool<uint64_t>(rest)) : Convolution::Pool<uint64_t>(dice);
+			entry.m_percentages = Statistics::Normalize(entry.m_counts, dice);
+		}
+		else
+		{
+			entry.m_percentages = prefix ? Convolution::Convolve(prefix->m_percentages, Convolution::Pool<double>(rest)) : Convolution::Pool<double>(dice);
+			Statistics::VerifyPercentages(dice, entry.m_percentages);
+		}
+
+		// Tables do it better for a single run of standard dice.
+		if (pStore && (signature.size() > 2 || (signature.size() == 2 && Convolution::StandardHistogram(signature[0], signature[1]).empty())))
+			pStore->Append(signature, signature_hash, entry.m_counts, entry.m_percentages);
+
+		auto const stored = cache.Insert(std::move(dice), std::make_shared<entry_t const>(std::move(entry)));
+		return { stored, &stored->m_percentages };
+	}
+}
+
+// Pool which keeps its histogram in between edits, for the interactive loop.
+// Adding or removing one die costs O(range) rather than a full rebuild.
+// Counts are exact, so removal by deconvolution loses nothing.
+struct dice_pool_t final
+{
+	void AddDie(int16_t face) noexcept
+	{
+		Convolution::AddDie(&m_counts, face);
+		m_dice.insert(std::ranges::upper_bound(m_dice, face, Dice::Arrange{}), face);
+	}
+
+	bool RemoveDie(int16_t face) noexcept
+	{
+		auto const it = std::ranges::find(m_dice, face);
+
+		if (it == m_dice.end())
+			return false;
+
+		Convolution::RemoveDie(&m_counts, face);
+		m_dice.erase(it);
+
+		return true;
+	}
+
+	constexpr void ShiftModifier(int16_t delta) noexcept { m_modifier += delta; }
+
+	// Dice must be sorted by Dice::Sort(). Only the difference from the current pool is applied.
+	void Assign(int16_t modifier, vector<int16_t> const& dice) noexcept
+	{
+		vector<int16_t> removal{}, addition{};
+		std::ranges::set_difference(m_dice, dice, std::back_inserter(removal), Dice::Arrange{});
+		std::ranges::set_difference(dice, m_dice, std::back_inserter(addition), Dice::Arrange{});
+
+		// Too many edits, starting over would be cheaper.
+		if (removal.size() + addition.size() >= dice.size())
+		{
+			m_counts = Statistics::ExactDistribution(dice);
+			m_dice = dice;
+		}
+		else
+		{
+			for (auto&& face : removal)
+				RemoveDie(face);
+
+			for (auto&& face : addition)
+				AddDie(face);
+		}
+
+		m_modifier = modifier;
+	}
+
+	constexpr auto LowerBound() const noexcept { return Statistics::LowerBound(m_modifier, m_dice); }
+
+	vector<double> Percentages() const noexcept
+	{
+		auto const total = std::ranges::fold_left(m_counts, Arithmatic::big_uint_t{}, std::plus<>{});
+
+		return
+			m_counts
+			| std::views::transform([&](auto&& cnt) noexcept { return Arithmatic::Ratio(cnt, total); })
+			| std::ranges::to<vector>();
+	}
+
+	int16_t m_modifier{};
+	vector<int16_t> m_dice{};	// sorted by Dice::Arrange
+	vector<Arithmatic::big_uint_t> m_counts{ 1 };
+};
+
+extern vector<string_view> ShuntingYardAlgorithm(string_view s);
+extern std::expected<int32_t, string> PostfixNotationEval(Bytecode::program_t const& program, span<int32_t const> rgiBindings) noexcept;
+
+// Random variables as operands of the Shunting-Yard RPN, so (1d6 + 2) * 2 or 2d6 * 1d4 comes out as an exact distribution.
+// Sums go by convolution. Everything else walks the non-zero outcomes of both sides only, no brute force over the dice.
+namespace Algebra
+{
+	// Dense histogram, or the non-zero outcomes alone when they are few and far between, e.g. 2d6 * 10 has 11 of them over a range of 101.
+	// Sparse ones keep the offset of every chance from the minimum, ascending.
+	struct random_variable_t final
+	{
+		constexpr bool IsSparse() const noexcept { return !m_offsets.empty(); }
+
+		constexpr int32_t Maximum() const noexcept { return m_minimum + (IsSparse() ? m_offsets.back() : (int32_t)m_chances.size() - 1); }
+
+		// Outcome of m_chances[idx].
+		constexpr int32_t OutcomeOf(size_t idx) const noexcept { return m_minimum + (IsSparse() ? m_offsets[idx] : (int32_t)idx); }
+
+		constexpr double ChanceOf(int32_t x) const noexcept
+		{
+			if (x < m_minimum || x > Maximum())
+				return 0;
+
+			if (!IsSparse())
+				return m_chances[x - m_minimum];
+
+			auto const it = std::ranges::lower_bound(m_offsets, x - m_minimum);
+			return it != m_offsets.end() && *it == x - m_minimum ? m_chances[it - m_offsets.begin()] : 0.0;
+		}
+
+		constexpr double Expectation() const noexcept
+		{
+			double ret{};
+
+			for (auto&& [i, flChance] : std::views::enumerate(m_chances))
+				ret += (double)OutcomeOf(i) * flChance;
+
+			return ret;
+		}
+
+		// Every bucket from the minimum to the maximum, which is what the printout and cdf_t take.
+		constexpr vector<double> Dense() const noexcept
+		{
+			if (!IsSparse())
+				return m_chances;
+
+			vector<double> ret(Maximum() - m_minimum + 1);
+
+			for (auto&& [offset, flChance] : std::views::zip(m_offsets, m_chances))
+				ret[offset] = flChance;
+
+			return ret;
+		}
+
+		int32_t m_minimum{};
+		vector<double> m_chances{ 1.0 };	// P(X = minimum + i), or P(X = minimum + offsets[i]) if sparse.
+		vector<int32_t> m_offsets{};	// empty if dense.
+		double m_truncation{};	// at most this much of the chance is misplaced, by exploding dice cut off at their depth.
+	};
+
+	// Sparse once less than one bucket in SPARSE_RATIO of the range is non-zero.
+	inline constexpr size_t SPARSE_RATIO = 4;
+
+	// Dense histogram in, whichever representation its density calls for out.
+	constexpr random_variable_t Pack(int32_t minimum, vector<double> rgflChances) noexcept
+	{
+		auto const nonzero = (size_t)std::ranges::count_if(rgflChances, [](double flChance) noexcept { return flChance > 0; });
+
+		if (nonzero * SPARSE_RATIO >= rgflChances.size())
+			return { minimum, std::move(rgflChances) };
+
+		random_variable_t ret{ minimum, {}, {} };
+		ret.m_chances.reserve(nonzero);
+		ret.m_offsets.reserve(nonzero);
+
+		for (auto&& [i, flChance] : std::views::enumerate(rgflChances))
+		{
+			if (flChance > 0)
+			{
+				ret.m_offsets.push_back((int32_t)i);
+				ret.m_chances.push_back(flChance);
+			}
+		}
+
+		return ret;
+	}
+
+	static_assert(
+		[]() consteval
+		{
+			vector<double> dist(101);
+			for (auto i = 0; i < 11; ++i)
+				dist[i * 10] = (6.0 - Arithmatic::abs(i - 5)) / 36.0;
+
+			auto const rv = Pack(20, dist);
+
+			return rv.IsSparse() && rv.m_chances.size() == 11 && rv.Maximum() == 120 && rv.ChanceOf(70) == 6.0 / 36.0 && rv.ChanceOf(71) == 0
+				&& rv.Dense() == dist && !Pack(2, vector(11, 1.0 / 11.0)).IsSparse();
+		}()
+	);
+
+	// Anything Dice::Parse() won't take? Operators, variables, or dice with mechanics such as 2d6r<3, 1d8min2 or 1d6!
+	constexpr bool Required(string_view sz) noexcept { return sz.find_first_not_of("1234567890dD+- "sv) != sz.npos; }
+
+	using result_t = std::expected<random_variable_t, string>;
+
+	inline result_t OutOfRange() noexcept
+	{
+		return std::unexpected(std::format(u8"無效輸入：結果超出可分析範圍[{}, {}]。\n", std::numeric_limits<int16_t>::min(), std::numeric_limits<int16_t>::max() - 20));
+	}
+
+	constexpr vector<pair<int64_t, double>> Support(random_variable_t const& rv) noexcept
+	{
+		vector<pair<int64_t, double>> ret{};
+
+		for (auto&& [i, flChance] : std::views::enumerate(rv.m_chances))
+		{
+			if (flChance > 0)
+				ret.emplace_back(rv.OutcomeOf(i), flChance);
+		}
+
+		return ret;
+	}
+
+	// Histogram of fn(x) or fn(x, y) over the non-zero outcomes. Results have to stay in the analysable range, same as dice.
+	// Results spread thin over their range are sorted and merged rather than laid over the whole range, in proportion to the support.
+	template <typename F, typename... Ts>
+	result_t Transform(F&& fn, Ts const&... rvs) noexcept
+	{
+		static_assert(sizeof...(Ts) == 1 || sizeof...(Ts) == 2);
+
+		auto const rgSupports = array{ Support(rvs)... };
+		auto const truncation = (rvs.m_truncation + ...);	// no pair could misplace more than either side did.
+		int64_t iMin = std::numeric_limits<int64_t>::max(), iMax = std::numeric_limits<int64_t>::min();
+
+		// Bounds first, then fill. Twice over the pairs is cheaper than a map of outcomes.
+		auto const Walk =
+			[&](auto&& fnVisit) noexcept
+			{
+				if constexpr (sizeof...(Ts) == 1)
+				{
+					for (auto&& [x, p] : rgSupports[0])
+						fnVisit(fn(x), p);
+				}
+				else
+				{
+					for (auto&& [x, p] : rgSupports[0])
+						for (auto&& [y, q] : rgSupports[1])
+							fnVisit(fn(x, y), p * q);
+				}
+			};
+
+		Walk([&](int64_t res, double) noexcept { iMin = std::min(iMin, res); iMax = std::max(iMax, res); });
+
+		if (iMin < std::numeric_limits<int16_t>::min() || iMax > std::numeric_limits<int16_t>::max() - 20)
+			return OutOfRange();
+
+		auto const range = (size_t)(iMax - iMin + 1);
+		auto const pairs = std::ranges::fold_left(rgSupports | std::views::transform([](auto&& rg) noexcept { return rg.size(); }), (size_t)1, std::multiplies<>{});
+
+		if (range <= pairs * SPARSE_RATIO)
+		{
+			vector<double> rgflChances(range);
+			Walk([&](int64_t res, double flChance) noexcept { rgflChances[res - iMin] += flChance; });
+
+			auto ret = Pack((int32_t)iMin, std::move(rgflChances));
+			ret.m_truncation = truncation;
+
+			return ret;
+		}
+
+		vector<pair<int64_t, double>> rgOutcomes{};
+		rgOutcomes.reserve(pairs);
+		Walk([&](int64_t res, double flChance) noexcept { rgOutcomes.emplace_back(res, flChance); });
+
+		// Stable, so equal outcomes add up in the same order as the dense walk does.
+		std::ranges::stable_sort(rgOutcomes, {}, &pair<int64_t, double>::first);
+
+		random_variable_t ret{ (int32_t)iMin, {}, {}, truncation };
+
+		for (auto&& [res, flChance] : rgOutcomes)
+		{
+			if (!ret.m_offsets.empty() && ret.m_offsets.back() == res - iMin)
+				ret.m_chances.back() += flChance;
+			else
+			{
+				ret.m_offsets.push_back((int32_t)(res - iMin));
+				ret.m_chances.push_back(flChance);
+			}
+		}
+
+		// Many pairs landing on few outcomes could still fill the range.
+		if (ret.m_chances.size() * SPARSE_RATIO >= range)
+			return random_variable_t{ ret.m_minimum, ret.Dense(), {}, truncation };
+
+		return ret;
+	}
+
+	// Saturated, so overflow ends up out of the range rather than wrapping into it.
+	constexpr int64_t Pow(int64_t base, int64_t exp) noexcept
+	{
+		constexpr int64_t CAP = int64_t(1) << 32;
+		int64_t ret = 1;
+
+		for (; exp > 0 && ret != 0 && Arithmatic::abs(ret) < CAP; --exp)
+			ret *= base;
+
+		return exp > 0 && ret != 0 ? (ret < 0 ? -CAP : CAP) : ret;
+	}
+
+	constexpr int64_t Factorial(int64_t n) noexcept
+	{
+		int64_t ret = 1;
+
+		for (; n > 1 && ret < (int64_t(1) << 32); --n)
+			ret *= n;
+
+		return ret;
+	}
+
+	static_assert(Pow(-2, 3) == -8 && Pow(7, 0) == 1 && Pow(10, 40) == int64_t(1) << 32 && Factorial(5) == 120 && Factorial(0) == 1);
+
+	// Exploding dice without a depth go this deep, so that less than this much of the chance is cut off per die.
+	inline constexpr double EXPLODE_TOLERANCE = 1e-9;
+
+	// A single die, its mechanics applied in the order written.
+	inline result_t DieOf(int16_t face, span<Bytecode::die_mechanic_t const> rgMechanics) noexcept
+	{
+		using enum Bytecode::mechanic_t;
+
+		random_variable_t ret{ 1, vector<double>(face, 1.0 / face) };
+		auto& chances = ret.m_chances;
+
+		for (auto&& [kind, value] : rgMechanics)
+		{
+			switch (kind)
+			{
+			case REROLL:
+			case REROLL_BELOW:
+			{
+				// Once and for all: P'(x) = P(x kept) + P(any rerolled) * P(x)
+				auto const Rerolled = [&](int64_t x) noexcept { return kind == REROLL ? x == value : x < value; };
+				double rerolled{};
+
+				for (auto&& [i, flChance] : std::views::enumerate(chances))
+					rerolled += Rerolled(ret.m_minimum + i) ? flChance : 0.0;
+
+				for (auto&& [i, flChance] : std::views::enumerate(chances))
+					flChance = (Rerolled(ret.m_minimum + i) ? 0.0 : flChance) + rerolled * flChance;
+
+				break;
+			}
+
+			case MINIMUM:
+			{
+				// Everything below is lifted onto the minimum.
+				if (value <= ret.m_minimum)
+					break;
+
+				if (value > ret.Maximum())
+					chances = { 1.0 };
+				else
+				{
+					auto const cut = (size_t)(value - ret.m_minimum);
+					auto const lifted = std::ranges::fold_left(chances | std::views::take(cut), 0.0, std::plus<>{});
+
+					chances.erase(chances.begin(), chances.begin() + cut);
+					chances.front() += lifted;
+				}
+
+				ret.m_minimum = value;
+				break;
+			}
+
+			case EXPLODE:
+			{
+				// The highest outcome rolls once more and adds up. At the cut off depth, the last roll is taken as it is.
+				auto const top = chances.back();
+				auto const highest = ret.Maximum();
+
+				if (top >= 1.0)
+					return std::unexpected(std::format(u8"無效輸入：d{}每次都會爆骰，無法分析。\n", face));
+
+				int32_t depth = value;
+
+				if (depth < 0)
+				{
+					depth = 0;
+
+					for (auto flCut = top; flCut > EXPLODE_TOLERANCE; flCut *= top)
+						++depth;
+				}
+
+				if ((int64_t)(depth + 1) * highest > std::numeric_limits<int16_t>::max() - 20)
+					return OutOfRange();
+
+				vector const kept(chances.begin(), chances.end() - 1);
+				auto rolled = chances;	// exploded at most k times, the k + 1 th roll taken as it is.
+
+				for (int32_t k = 0; k < depth; ++k)
+				{
+					// next[i] <-> minimum + i, and a roll of the highest shifts the ones after it by highest.
+					vector<double> next((size_t)highest + rolled.size());
+					std::ranges::copy(kept, next.begin());
+
+					for (auto&& [flNext, flRolled] : std::views::zip(next | std::views::drop(highest), rolled))
+						flNext += top * flRolled;
+
+					rolled = std::move(next);
+				}
+
+				chances = std::move(rolled);
+				ret.m_truncation += std::pow(top, depth + 1);
+				break;
+			}
+
+			case CRITICAL:
+			case KEEP_HIGHEST:
+			case KEEP_LOWEST:
+			case DROP_HIGHEST:
+			case DROP_LOWEST:
+			case SUCCESS:
+				break;	// of the pool, see Keep() and Successes().
+
+			default:
+				std::unreachable();
+			}
+		}
+
+		return ret;
+	}
+
+	// Sum of the keep highest, or lowest, of count dice alike. By order statistics rather than every roll, e.g. 4d6 drop the lowest.
+	// Faces are walked from the kept end, placing any number of dice onto each. The first keep dice placed are the kept ones,
+	// hence (dice placed, sum kept) makes the whole state. O(faces * count^2 * range of the kept sum).
+	constexpr random_variable_t Keep(random_variable_t const& die, int32_t count, int32_t keep, bool bHighest) noexcept
+	{
+		keep = std::clamp(keep, 0, count);
+
+		auto const faces = die.m_chances.size();
+		auto const range = (size_t)keep * (faces - 1) + 1;	// kept sum off keep * minimum.
+
+		// dp[j][s]: j dice placed, s the kept sum so far.
+		vector dp(count + 1, vector<double>(range));
+		auto next = dp;
+		dp[0][0] = 1;
+
+		for (size_t k = 0; k < faces; ++k)
+		{
+			auto const i = bHighest ? faces - 1 - k : k;
+			auto const p = die.m_chances[i];
+
+			if (p <= 0)
+				continue;
+
+			for (auto&& row : next)
+				std::ranges::fill(row, 0.0);
+
+			for (int32_t j = 0; j <= count; ++j)
+			{
+				auto const n = count - j;
+				auto w = 1.0;	// C(n, c) * p^c, c out of the n dice left showing this face.
+
+				for (int32_t c = 0; c <= n; ++c)
+				{
+					if (c > 0)
+						w *= (double)(n - c + 1) / (double)c * p;
+
+					auto const shift = (size_t)std::clamp(keep - j, 0, c) * i;
+
+					for (size_t s = 0; s + shift < range; ++s)
+						next[j + c][s + shift] += dp[j][s] * w;
+				}
+			}
+
+			std::swap(dp, next);
+		}
+
+		return { keep * die.m_minimum, std::move(dp[count]) };
+	}
+
+	static_assert(
+		[]() consteval
+		{
+			// 4d6 drop the lowest: 3 in 1 of 1296 rolls, 18 in 21 of them. 2d20 keep the highest: 20 in 39 of 400.
+			auto const stat = Keep(random_variable_t{ 1, vector(6, 1.0 / 6.0) }, 4, 3, true);
+			auto const adv = Keep(random_variable_t{ 1, vector(20, 1.0 / 20.0) }, 2, 1, true);
+			auto const disadv = Keep(random_variable_t{ 1, vector(20, 1.0 / 20.0) }, 2, 1, false);
+
+			return stat.m_minimum == 3 && stat.Maximum() == 18
+				&& Arithmatic::abs(stat.ChanceOf(3) - 1.0 / 1296.0) < 1e-15 && Arithmatic::abs(stat.ChanceOf(18) - 21.0 / 1296.0) < 1e-15
+				&& Arithmatic::abs(stat.Expectation() - 15869.0 / 1296.0) < 1e-12
+				&& Arithmatic::abs(adv.ChanceOf(20) - 39.0 / 400.0) < 1e-15 && Arithmatic::abs(disadv.ChanceOf(1) - 39.0 / 400.0) < 1e-15;
+		}()
+	);
+
+	// Number of successes among count dice alike, each of threshold or more being one, and each of critical or more yet another.
+	// Every die comes down to a distribution of 0, 1 or 2 successes, which is then raised to the power of count like any other.
+	constexpr random_variable_t Successes(random_variable_t const& die, int32_t count, int32_t threshold, std::optional<int32_t> critical) noexcept
+	{
+		vector<double> single(critical ? 3 : 2);
+
+		for (auto&& [i, flChance] : std::views::enumerate(die.m_chances))
+		{
+			auto const x = die.OutcomeOf(i);
+			single[(x >= threshold) + (critical && x >= *critical)] += flChance;
+		}
+
+		return { 0, Convolution::Power(std::move(single), count) };
+	}
+
+	static_assert(
+		[]() consteval
+		{
+			// 2d6 counting 5 and 6: none in 16 of 36 rolls, two in 4. With 6 counting twice, 2 in 9 of them and 4 in 1.
+			auto const plain = Successes(random_variable_t{ 1, vector(6, 1.0 / 6.0) }, 2, 5, std::nullopt);
+			auto const doubled = Successes(random_variable_t{ 1, vector(6, 1.0 / 6.0) }, 2, 5, 6);
+
+			return plain.m_minimum == 0 && plain.Maximum() == 2 && doubled.Maximum() == 4
+				&& Arithmatic::abs(plain.ChanceOf(0) - 16.0 / 36.0) < 1e-15 && Arithmatic::abs(plain.ChanceOf(2) - 4.0 / 36.0) < 1e-15
+				&& Arithmatic::abs(doubled.ChanceOf(2) - 9.0 / 36.0) < 1e-15 && Arithmatic::abs(doubled.ChanceOf(4) - 1.0 / 36.0) < 1e-15
+				&& Arithmatic::abs(doubled.Expectation() - 1.0) < 1e-15;
+		}()
+	);
+
+	// What Bytecode::Execute() runs on, a stack of distributions.
+	struct domain_t final
+	{
+		/*#UPDATE_AT_CPP23_static_operator*/ random_variable_t Constant(int32_t val) const noexcept { return { val, { 1.0 } }; }
+
+		result_t Dice(int16_t count, int16_t face) const noexcept
+		{
+			if (m_critical)
+				return Twice(domain_t{}.Dice(count, face));
+
+			if (count < 0)
+				return std::unexpected(std::format(u8"無效輸入：骰子數量'{}'不可為負。\n", count));
+
+			vector const dice(count, face);
+
+			if (!Statistics::RangeFits(0, dice))
+				return OutOfRange();
+
+			return random_variable_t{ Statistics::LowerBound(0, dice), *PoolCache::Percentages(dice) };
+		}
+
+		// Modified dice are summed up by the same squaring as plain ones, only the single die differs.
+		result_t Dice(int16_t count, int16_t face, span<Bytecode::die_mechanic_t const> rgMechanics) const noexcept
+		{
+			if (m_critical)
+				return Twice(domain_t{}.Dice(count, face, rgMechanics));
+
+			if (count < 0)
+				return std::unexpected(std::format(u8"無效輸入：骰子數量'{}'不可為負。\n", count));
+
+			auto const die = DieOf(face, rgMechanics);
+
+			if (!die)
+				return die;
+
+			// Kept or dropped dice still count as rolled.
+			auto const pool = std::ranges::find_if(rgMechanics, &Bytecode::die_mechanic_t::OfPool);
+
+			if (pool != rgMechanics.end() && pool->m_kind == Bytecode::mechanic_t::SUCCESS)
+			{
+				auto const critical = std::ranges::find(rgMechanics, Bytecode::mechanic_t::CRITICAL, &Bytecode::die_mechanic_t::m_kind);
+
+				if ((int64_t)count * (critical != rgMechanics.end() ? 2 : 1) > std::numeric_limits<int16_t>::max() - 20)
+					return OutOfRange();
+
+				auto ret = Successes(*die, count, pool->m_value, critical != rgMechanics.end() ? std::optional<int32_t>{ critical->m_value } : std::nullopt);
+				ret.m_truncation = count * die->m_truncation;
+
+				return ret;
+			}
+
+			auto kept = (int32_t)count;
+
+			if (pool != rgMechanics.end())
+			{
+				switch (pool->m_kind)
+				{
+				case Bytecode::mechanic_t::KEEP_HIGHEST:
+				case Bytecode::mechanic_t::KEEP_LOWEST:
+					kept = std::min<int32_t>(pool->m_value, count);
+					break;
+
+				default:
+					kept = std::max<int32_t>(count - pool->m_value, 0);
+					break;
+				}
+			}
+
+			auto const minimum = (int64_t)kept * die->m_minimum;
+			auto const maximum = (int64_t)kept * die->Maximum();
+
+			if (minimum < std::numeric_limits<int16_t>::min() || maximum > std::numeric_limits<int16_t>::max() - 20)
+				return OutOfRange();
+
+			auto ret =
+				pool != rgMechanics.end()
+				? Pack((int32_t)minimum, Keep(*die, count, kept, pool->m_kind == Bytecode::mechanic_t::KEEP_HIGHEST || pool->m_kind == Bytecode::mechanic_t::DROP_LOWEST).m_chances)
+				: Pack((int32_t)minimum, Convolution::Power(die->m_chances, count));
+
+			ret.m_truncation = count * die->m_truncation;
+
+			return ret;
+		}
+
+		result_t Apply(Bytecode::op_t op, random_variable_t const& lhs, random_variable_t const& rhs) const noexcept
+		{
+			using enum Bytecode::op_t;
+
+			switch (op)
+			{
+			case ADD:
+			case SUBTRACT:
+			{
+				auto const negative = op == SUBTRACT;
+
+				// Sparse on either side: pairs of outcomes, costing in proportion to the supports rather than the ranges.
+				if (lhs.IsSparse() || rhs.IsSparse())
+				{
+					if (negative)
+						return Transform([](int64_t x, int64_t y) noexcept { return x - y; }, lhs, rhs);
+					else
+						return Transform([](int64_t x, int64_t y) noexcept { return x + y; }, lhs, rhs);
+				}
+
+				// X - Y == X + (-Y), where -Y is simply mirrored.
+				auto const rhs_minimum = negative ? -rhs.Maximum() : rhs.m_minimum;
+				auto const minimum = (int64_t)lhs.m_minimum + rhs_minimum;
+				auto const maximum = minimum + (int64_t)(lhs.m_chances.size() + rhs.m_chances.size()) - 2;
+
+				if (minimum < std::numeric_limits<int16_t>::min() || maximum > std::numeric_limits<int16_t>::max() - 20)
+					return OutOfRange();
+
+				// Dense ones rarely add up to a gapped one, but telling costs a single pass.
+				auto ret = Pack(
+					(int32_t)minimum,
+					Convolution::Convolve(lhs.m_chances, negative ? rhs.m_chances | std::views::reverse | std::ranges::to<vector>() : rhs.m_chances)
+				);
+
+				ret.m_truncation = lhs.m_truncation + rhs.m_truncation;
+				return ret;
+			}
+
+			case MULTIPLY:
+				return Transform([](int64_t x, int64_t y) noexcept { return x * y; }, lhs, rhs);
+
+			case DIVIDE:
+			case MODULO:
+				if (rhs.ChanceOf(0) > 0)
+					return std::unexpected(string{ u8"無效輸入：除數可能為零。\n" });
+
+				// Truncated toward zero, i.e. halving 7 damage gives 3.
+				if (op == DIVIDE)
+					return Transform([](int64_t x, int64_t y) noexcept { return x / y; }, lhs, rhs);
+				else
+					return Transform([](int64_t x, int64_t y) noexcept { return x % y; }, lhs, rhs);
+
+			case POWER:
+				if (rhs.m_minimum < 0)
+					return std::unexpected(string{ u8"無效輸入：指數不可為負。\n" });
+
+				return Transform(&Pow, lhs, rhs);
+
+			default:
+				std::unreachable();
+			}
+		}
+
+		result_t Factorial(random_variable_t const& rv) const noexcept
+		{
+			if (rv.m_minimum < 0)
+				return std::unexpected(string{ u8"無效輸入：階乘不可為負。\n" });
+
+			return Transform(&Algebra::Factorial, rv);
+		}
+
+		// Critical hits roll every dice term twice, while the modifiers stay as they are.
+		bool m_critical{};
+
+	private:
+		// Two independent rolls of the same term. Rolling 2 * count instead would be wrong once dice are kept or dropped.
+		result_t Twice(result_t const& once) const noexcept
+		{
+			if (!once)
+				return once;
+
+			return Apply(Bytecode::op_t::ADD, *once, *once);
+		}
+	};
+
+	// ShuntingYardAlgorithm() knows binary operators only. A minus leading the expression or a parenthesis becomes 0 - x.
+	constexpr void InsertImplicitZeros(string* psz) noexcept
+	{
+		auto& sz = *psz;
+
+		for (size_t pos = 0; pos < sz.size(); ++pos)
+		{
+			if (sz[pos] != '-')
+				continue;
+
+			if (auto const prev = pos == 0 ? sz.npos : sz.find_last_not_of(' ', pos - 1); prev == sz.npos || sz[prev] == '(')
+				sz.insert(pos++, 1, '0');
+		}
+	}
+
+	static_assert(
+		[]() consteval
+		{
+			string sz{ "-1d4 + 1d6!" }, sz2{ " -(2 - (-1d6))" };
+			InsertImplicitZeros(&sz);
+			InsertImplicitZeros(&sz2);
+
+			return sz == "0-1d4 + 1d6!" && sz2 == " 0-(2 - (0-1d6))";
+		}()
+	);
+
+	// Keep the program for formulas evaluated over and over, with only the variables changing.
+	inline std::expected<Bytecode::program_t, string> Compile(string_view szExpr) noexcept
+	{
+		string szInput{ szExpr };
+
+		// ShuntingYardAlgorithm() does not survive an unmatched ')'.
+		for (int depth = 0; auto&& c : szInput)
+		{
+			if (!"1234567890!^*/%+-()<_ "sv.contains(c) && !std::isalpha((unsigned char)c))
+				return std::unexpected(std::format(u8"無效輸入：字元'{}'無法解讀\n", c));
+
+			if ((depth += (c == '(') - (c == ')')) < 0)
+				return std::unexpected(string{ u8"格式錯誤：括號不成對。\n" });
+		}
+
+		InsertImplicitZeros(&szInput);
+
+		try
+		{
+			// Tokens are views into szInput, but the program keeps nothing of them.
+			return Bytecode::Compile(ShuntingYardAlgorithm(szInput));
+		}
+		catch (std::invalid_argument const&)
+		{
+			return std::unexpected(string{ u8"格式錯誤：括號不成對。\n" });
+		}
+	}
+
+	inline result_t Evaluate(Bytecode::program_t const& program, span<int32_t const> rgiBindings = {}) noexcept
+	{
+		return Bytecode::Execute<random_variable_t>(program, rgiBindings, domain_t{});
+	}
+
+	// Compile() memorized by the text of the expression, so a batch or a daemon fed the same formula over and over decodes it once.
+	// Failures are not kept, they are cheap to find again.
+	inline std::expected<std::shared_ptr<Bytecode::program_t const>, string> Program(string_view szExpr) noexcept
+	{
+		static sharded_cache_t<string, Bytecode::program_t> cache{ 4096 };
+		string szKey{ szExpr };
+
+		if (auto const hit = cache.Find(szKey); hit)
+			return hit;
+
+		auto program = Compile(szExpr);
+
+		if (!program)
+			return std::unexpected(program.error());
+
+		return cache.Insert(std::move(szKey), std::make_shared<Bytecode::program_t const>(std::move(*program)));
+	}
+
+	inline result_t Evaluate(string_view szExpr) noexcept
+	{
+		auto const program = Program(szExpr);
+
+		if (!program)
+			return std::unexpected(program.error());
+
+		return Evaluate(**program);
+	}
+}
+
+// Queries beyond a single expression: a keyword, fields separated by spaces, a colon, and then the expression.
+// e.g. attack 2x +7 vs 16: 1d8 + 4
+namespace Query
+{
+	struct split_t final
+	{
+		vector<string_view> m_fields{};	// views into the line.
+		string_view m_body{};
+	};
+
+	// Space separated, as views into sz.
+	constexpr vector<string_view> Fields(string_view sz) noexcept
+	{
+		constexpr string_view delimiters{ " \t" };
+		vector<string_view> ret{};
+
+		for (auto pos = sz.find_first_not_of(delimiters); pos != sz.npos; pos = sz.find_first_not_of(delimiters, pos))
+		{
+			auto const end = std::min(sz.find_first_of(delimiters, pos), sz.size());
+
+			ret.push_back(sz.substr(pos, end - pos));
+			pos = end;
+		}
+
+		return ret;
+	}
+
+	constexpr std::optional<split_t> Split(string_view sz, string_view szKeyword) noexcept
+	{
+		sz.remove_prefix(szKeyword.size());
+
+		auto const colon = sz.find(':');
+
+		if (colon == sz.npos)
+			return std::nullopt;
+
+		return split_t{ .m_fields{ Fields(sz.substr(0, colon)) }, .m_body{ sz.substr(colon + 1) } };
+	}
+
+	// adv, dis or disadv, and ea, whole fields only. nullptr for anything else.
+	constexpr array<double, 20> const* D20Of(string_view szField) noexcept
+	{
+		if (szField == "adv")
+			return &AbilityCheck::ADVANTAGED_D20;
+		if (szField == "dis" || szField == "disadv")
+			return &AbilityCheck::DISADVANTAGED_D20;
+		if (szField == "ea")
+			return &AbilityCheck::ELVEN_ACCURACY_D20;
+
+		return nullptr;
+	}
+
+	static_assert(
+		[]() consteval
+		{
+			auto const parts = Split("attack 2x +7 vs16 disadv: 1d8 + 4", "attack");
+
+			return parts && parts->m_body == " 1d8 + 4" && parts->m_fields == vector<string_view>{ "2x", "+7", "vs16", "disadv" }
+				&& !Split("attack +7 vs 16", "attack") && Split("solve:1d20", "solve")->m_fields.empty()
+				&& D20Of("disadv") == &AbilityCheck::DISADVANTAGED_D20 && !D20Of("advantage") && !D20Of("d");
+		}()
+	);
+
+	// All of sz, nothing left over.
+	template <typename T>
+	std::optional<T> NumberOf(string_view sz) noexcept
+	{
+		T ret{};
+		auto const [ptr, ec] = std::from_chars(sz.data(), sz.data() + sz.size(), ret);
+
+		if (sz.empty() || ec != std::errc{} || ptr != sz.data() + sz.size())
+			return std::nullopt;
+
+		return ret;
+	}
+
+	// The number after szKey, "vs16" and "vs 16" alike. The latter takes the next field as well.
+	template <typename T>
+	std::optional<T> ValueOf(span<string_view const> rgszFields, size_t* pi, string_view szKey) noexcept
+	{
+		auto sz = rgszFields[*pi].substr(szKey.size());
+
+		if (sz.empty() && *pi + 1 < rgszFields.size())
+			sz = rgszFields[++*pi];
+
+		return NumberOf<T>(sz);
+	}
+}
+
+// One round of attacks against one target, in a single distribution of the total damage.
+// Each attack misses for nothing, hits for the damage, or crits for the damage with its dice rolled twice.
+// e.g. attack 2x +7 vs 16 crit19 adv: 1d8 + 4
+namespace Attack
+{
+	struct request_t final
+	{
+		int16_t m_attacks{ 1 };
+		int16_t m_bonus{};
+		int16_t m_ac{};
+		int16_t m_crit{ 20 };	// natural rolls of this or more crit.
+		array<double, 20> m_d20{ AbilityCheck::NORMAL_D20 };
+		string m_damage{};
+	};
+
+	constexpr bool Required(string_view sz) noexcept { return sz.starts_with("attack"); }
+
+	// { miss, hit, crit }
+	// A natural 1 always misses, and a roll in the crit range always hits, no matter the AC.
+	constexpr array<double, 3> Chances(int16_t bonus, int16_t ac, int16_t crit, array<double, 20> const& d20) noexcept
+	{
+		array<double, 3> ret{};
+
+		for (int16_t v = 1; v <= 20; ++v)
+		{
+			if (v == 1)
+				ret[0] += d20[v - 1];
+			else if (v >= crit)
+				ret[2] += d20[v - 1];
+			else
+				ret[v + bonus >= ac ? 1 : 0] += d20[v - 1];
+		}
+
+		return ret;
+	}
+
+	static_assert(
+		[]() consteval
+		{
+			// +5 vs AC 15 hits on 10 to 19. Advantage crits in 39 of 400, and crit19 doubles the range.
+			auto const normal = Chances(5, 15, 20, AbilityCheck::NORMAL_D20);
+			auto const adv = Chances(5, 15, 20, AbilityCheck::ADVANTAGED_D20);
+			auto const improved = Chances(5, 15, 19, AbilityCheck::NORMAL_D20);
+			auto const hopeless = Chances(0, 30, 20, AbilityCheck::NORMAL_D20);
+
+			return Arithmatic::abs(normal[0] - 0.45) < 1e-15 && Arithmatic::abs(normal[1] - 0.5) < 1e-15 && Arithmatic::abs(normal[2] - 0.05) < 1e-15
+				&& Arithmatic::abs(adv[2] - 39.0 / 400.0) < 1e-15
+				&& Arithmatic::abs(improved[1] - 0.45) < 1e-15 && Arithmatic::abs(improved[2] - 0.1) < 1e-15
+				&& Arithmatic::abs(hopeless[2] - 0.05) < 1e-15 && hopeless[1] == 0;
+		}()
+	);
+
+	std::expected<request_t, string> Parse(string_view sz) noexcept
+	{
+		auto const parts = Query::Split(sz, "attack");
+
+		if (!parts)
+			return std::unexpected(string{ u8"格式錯誤：傷害算式須以':'隔開。\n\t例如：attack 2x +7 vs 16 crit19 adv: 1d8 + 4\n" });
+
+		request_t ret{ .m_damage{ string{ parts->m_body } } };
+
+		// Each kind at most once, or the latter would silently win.
+		enum : uint8_t { ATTACKS = 1 << 0, BONUS = 1 << 1, AC = 1 << 2, CRIT = 1 << 3, D20 = 1 << 4 };
+		uint8_t seen{};
+
+		auto const& rgszFields = parts->m_fields;
+
+		for (size_t i = 0; i < rgszFields.size(); ++i)
+		{
+			auto const szField = rgszFields[i];
+			uint8_t field{};
+			bool bValid = true;
+
+			if (szField.starts_with("vs"))
+			{
+				field = AC;
+
+				if (auto const val = Query::ValueOf<int16_t>(rgszFields, &i, "vs"); (bValid = val.has_value()))
+					ret.m_ac = *val;
+			}
+			else if (szField.starts_with("crit"))
+			{
+				field = CRIT;
+				auto const val = Query::ValueOf<int16_t>(rgszFields, &i, "crit");
+
+				if (val && (*val < 2 || *val > 20))
+					return std::unexpected(std::format(u8"無效輸入：重擊範圍'{}'須介於2至20。\n", *val));
+
+				if ((bValid = val.has_value()))
+					ret.m_crit = *val;
+			}
+			else if (auto const pD20 = Query::D20Of(szField); pD20)
+				field = D20, ret.m_d20 = *pD20;
+			else if (szField.starts_with('+') || szField.starts_with('-'))
+			{
+				field = BONUS;
+
+				// "+5" or "+ 5" alike.
+				if (auto const val = Query::ValueOf<int16_t>(rgszFields, &i, szField.substr(0, 1)); (bValid = val.has_value()))
+					ret.m_bonus = szField.starts_with('-') ? -*val : *val;
+			}
+			else if (szField.ends_with('x'))
+			{
+				field = ATTACKS;
+
+				if (auto const val = Query::NumberOf<int16_t>(szField.substr(0, szField.size() - 1)); (bValid = val && *val > 0))
+					ret.m_attacks = *val;
+			}
+			else
+				bValid = false;
+
+			if (!bValid)
+				return std::unexpected(std::format(u8"格式錯誤：無法解讀攻擊參數。\n\t錯誤位於'{}'處。\n", szField));
+
+			if (seen & field)
+				return std::unexpected(std::format(u8"格式錯誤：攻擊參數重複。\n\t錯誤位於'{}'處。\n", szField));
+
+			seen |= field;
+		}
+
+		if (!(seen & AC))
+			return std::unexpected(string{ u8"格式錯誤：缺少目標護甲等級'vs'。\n" });
+
+		return ret;
+	}
+
+	// Per attack, the mixture of the three outcomes. Per round, the sum of the attacks by squaring.
+	Algebra::result_t Evaluate(request_t const& req) noexcept
+	{
+		using Algebra::random_variable_t;
+
+		auto const program = Algebra::Program(req.m_damage);
+
+		if (!program)
+			return std::unexpected(program.error());
+
+		auto const hit = Bytecode::Execute<random_variable_t>(**program, {}, Algebra::domain_t{});
+		auto const crit = Bytecode::Execute<random_variable_t>(**program, {}, Algebra::domain_t{ .m_critical{ true } });
+
+		if (!hit)
+			return hit;
+		if (!crit)
+			return crit;
+
+		auto const [flMiss, flHit, flCrit] = Chances(req.m_bonus, req.m_ac, req.m_crit, req.m_d20);
+		auto const minimum = std::min({ 0, hit->m_minimum, crit->m_minimum });
+		auto const maximum = std::max({ 0, hit->Maximum(), crit->Maximum() });
+
+		if ((int64_t)minimum * req.m_attacks < std::numeric_limits<int16_t>::min() || (int64_t)maximum * req.m_attacks > std::numeric_limits<int16_t>::max() - 20)
+			return Algebra::OutOfRange();
+
+		vector<double> single(maximum - minimum + 1);
+		single[-minimum] += flMiss;
+
+		for (auto&& [rv, flChance] : { pair{ &*hit, flHit }, pair{ &*crit, flCrit } })
+		{
+			auto const rgflDamage = rv->Dense();
+
+			for (auto&& [i, flDamage] : std::views::enumerate(rgflDamage))
+				single[rv->m_minimum - minimum + i] += flChance * flDamage;
+		}
+
+		auto ret = Algebra::Pack(minimum * req.m_attacks, Convolution::Power(std::move(single), req.m_attacks));
+		ret.m_truncation = req.m_attacks * (flHit * hit->m_truncation + flCrit * crit->m_truncation);
+
+		return ret;
+	}
+
+	inline Algebra::result_t Evaluate(string_view sz) noexcept
+	{
+		auto const req = Parse(sz);
+
+		if (!req)
+			return std::unexpected(req.error());
+
+		return Evaluate(*req);
+	}
+}
+
+// Contested rolls, one expression against another, e.g. adv d20 + 5 vs d20 + 3
+// Both sides are distributions alike, so A - B is all it takes: the win is P(A - B > 0), the tie P(A - B == 0).
+namespace Opposed
+{
+	struct outcome_t final
+	{
+		double m_win{};
+		double m_tie{};
+		double m_loss{};
+		Algebra::random_variable_t m_difference{};
+	};
+
+	// Offset of "vs" standing as a field of its own, npos if none. Words merely containing it do not count.
+	constexpr size_t SeparatorOf(string_view sz) noexcept
+	{
+		for (auto&& szField : Query::Fields(sz))
+		{
+			if (szField == "vs")
+				return (size_t)(szField.data() - sz.data());
+		}
+
+		return sz.npos;
+	}
+
+	// Not to be confused with the AC of an attack, which is checked first.
+	constexpr bool Required(string_view sz) noexcept { return SeparatorOf(sz) != sz.npos; }
+
+	static_assert(Required("adv d20 + 5 vs d20 + 3") && SeparatorOf("d20 vs d6") == 4 && !Required("d20vsd6") && !Required("2d6 versus"));
+
+	// { win, tie, loss } out of the distribution of A - B.
+	constexpr array<double, 3> Chances(Algebra::random_variable_t const& diff) noexcept
+	{
+		array<double, 3> ret{};
+
+		for (auto&& [i, flChance] : std::views::enumerate(diff.m_chances))
+		{
+			auto const x = diff.OutcomeOf(i);
+			ret[x > 0 ? 0 : (x == 0 ? 1 : 2)] += flChance;
+		}
+
+		return ret;
+	}
+
+	static_assert(
+		[]() consteval
+		{
+			// d6 vs d6: ties in 6 of 36 rolls, the rest split evenly.
+			auto const chances = Chances(Algebra::random_variable_t{ -5, { 1 / 36.0, 2 / 36.0, 3 / 36.0, 4 / 36.0, 5 / 36.0, 6 / 36.0, 5 / 36.0, 4 / 36.0, 3 / 36.0, 2 / 36.0, 1 / 36.0 } });
+
+			return Arithmatic::abs(chances[0] - 15 / 36.0) < 1e-15 && Arithmatic::abs(chances[1] - 6 / 36.0) < 1e-15 && Arithmatic::abs(chances[2] - 15 / 36.0) < 1e-15;
+		}()
+	);
+
+	// A plain pool may lead with adv, dis or ea as a field of its own, making one of its d20 rolled as in AbilityCheck.
+	// Expressions have their own, 2d20kh1 and alike. Solve::Evaluate() goes through here as well.
+	Algebra::result_t Side(string_view sz) noexcept
+	{
+		std::optional<array<double, 20>> d20{};
+
+		if (auto const rgszFields = Query::Fields(sz); !rgszFields.empty())
+		{
+			if (auto const pD20 = Query::D20Of(rgszFields.front()); pD20)
+			{
+				d20 = *pD20;
+				sz = sz.substr(rgszFields.front().data() + rgszFields.front().size() - sz.data());
+			}
+		}
+
+		// UTIL_Trim() would stop at the first inner space.
+		sz.remove_prefix(std::min(sz.find_first_not_of(" \t"), sz.size()));
+
+		if (!d20 && Algebra::Required(sz))
+			return Algebra::Evaluate(sz);
+
+		auto const parsed = Dice::Parse(string{ sz });
+
+		if (!parsed)
+			return std::unexpected(parsed.error());
+
+		auto const& [modifier, dice] = *parsed;
+
+		if (!Statistics::RangeFits(modifier, dice))
+			return Algebra::OutOfRange();
+
+		if (!d20)
+			return Algebra::random_variable_t{ Statistics::LowerBound(modifier, dice), *PoolCache::Percentages(dice) };
+
+		auto rest{ dice };
+
+		if (auto const it = std::ranges::find(rest, 20); it != rest.end())
+			rest.erase(it);
+		else
+			return std::unexpected(std::format(u8"格式錯誤：'{}'當中沒有d20可供優劣勢。\n", sz));
+
+		return Algebra::random_variable_t{ Statistics::LowerBound(modifier, dice), AbilityCheck::Percentages(modifier, rest, *d20) };
+	}
+
+	std::expected<outcome_t, string> Evaluate(string_view sz) noexcept
+	{
+		auto const pos = SeparatorOf(sz);
+		auto const lhs = Side(sz.substr(0, pos));
+		auto const rhs = Side(sz.substr(pos + 2));
+
+		if (!lhs)
+			return std::unexpected(lhs.error());
+		if (!rhs)
+			return std::unexpected(rhs.error());
+
+		auto diff = Algebra::domain_t{}.Apply(Bytecode::op_t::SUBTRACT, *lhs, *rhs);
+
+		if (!diff)
+			return std::unexpected(diff.error());
+
+		auto const [flWin, flTie, flLoss] = Chances(*diff);
+
+		return outcome_t{
+			.m_win{ flWin },
+			.m_tie{ flTie },
+			.m_loss{ flLoss },
+			.m_difference{ std::move(*diff) },
+		};
+	}
+}
+
+// Forward is P(pool + bonus >= DC). Inverse is the bonus, the DC, or the number of extra dice that a target chance calls for.
+// e.g. solve 65% dc18 bonus?: 1d20 + 1d4
+//		solve 65% dc?: adv d20 + 5
+//		solve 90% dc30 d6?: 1d20 + 5
+namespace Solve
+{
+	enum struct unknown_t : uint8_t
+	{
+		NONE,
+		BONUS,
+		DC,
+		DICE,
+	};
+
+	struct request_t final
+	{
+		unknown_t m_unknown{ unknown_t::NONE };
+		int16_t m_face{};	// of the dice to add.
+		std::optional<int32_t> m_dc{};
+		double m_chance{};
+		string m_pool{};
+	};
+
+	struct answer_t final
+	{
+		int32_t m_value{};
+		double m_chance{};	// P(X >= DC) actually met.
+	};
+
+	// Not worth rolling more than that for a single check.
+	inline constexpr int16_t MAX_EXTRA_DICE = 1000;
+
+	constexpr bool Required(string_view sz) noexcept { return sz.starts_with("solve"); }
+
+	std::expected<request_t, string> Parse(string_view sz) noexcept
+	{
+		auto const parts = Query::Split(sz, "solve");
+
+		if (!parts)
+			return std::unexpected(string{ u8"格式錯誤：骰子須以':'隔開。\n\t例如：solve 65% dc18 bonus?: 1d20 + 1d4\n" });
+
+		request_t ret{ .m_pool{ string{ parts->m_body } } };
+
+		// Each kind at most once, same as Attack::Parse().
+		enum : uint8_t { UNKNOWN = 1 << 0, DC = 1 << 1, CHANCE = 1 << 2 };
+		uint8_t seen{};
+
+		auto const& rgszFields = parts->m_fields;
+
+		for (size_t i = 0; i < rgszFields.size(); ++i)
+		{
+			auto const szField = rgszFields[i];
+			uint8_t field{};
+			bool bValid = true;
+
+			if (szField == "bonus?")
+				field = UNKNOWN, ret.m_unknown = unknown_t::BONUS;
+			else if (szField == "dc?")
+				field = UNKNOWN, ret.m_unknown = unknown_t::DC;
+			else if (szField.starts_with("dc"))
+			{
+				field = DC;
+
+				if (auto const val = Query::ValueOf<int32_t>(rgszFields, &i, "dc"); (bValid = val.has_value()))
+					ret.m_dc = *val;
+			}
+			else if (szField.starts_with('d') && szField.ends_with('?'))
+			{
+				field = UNKNOWN;
+
+				if (auto const val = Query::NumberOf<int16_t>(szField.substr(1, szField.size() - 2)); (bValid = val && *val > 0))
+					ret.m_unknown = unknown_t::DICE, ret.m_face = *val;
+			}
+			else if (szField.ends_with('%'))
+			{
+				field = CHANCE;
+
+				if (auto const val = Query::NumberOf<double>(szField.substr(0, szField.size() - 1)); (bValid = val && *val > 0 && *val <= 100))
+					ret.m_chance = *val / 100.0;
+			}
+			else
+				bValid = false;
+
+			if (!bValid)
+				return std::unexpected(std::format(u8"格式錯誤：無法解讀求解參數。\n\t錯誤位於'{}'處。\n", szField));
+
+			if (seen & field)
+				return std::unexpected(std::format(u8"格式錯誤：求解參數重複。\n\t錯誤位於'{}'處。\n", szField));
+
+			seen |= field;
+		}
+
+		if (!(seen & UNKNOWN))
+			return std::unexpected(string{ u8"格式錯誤：須指明所求，bonus?、dc?或d6?之類。\n" });
+
+		if (!(seen & CHANCE))
+			return std::unexpected(string{ u8"格式錯誤：缺少目標機率，例如65%。\n" });
+
+		if (ret.m_unknown != unknown_t::DC && !ret.m_dc)
+			return std::unexpected(string{ u8"格式錯誤：缺少難度'dc'。\n" });
+
+		return ret;
+	}
+
+	// The pool is rolled up once. Bonus and DC are then one binary search on its CDF, a Challenge() per probe.
+	// Extra dice do change the shape, so they are added one at a time instead, each costing a convolution.
+	std::expected<answer_t, string> Evaluate(request_t const& req) noexcept
+	{
+		auto rv = Opposed::Side(req.m_pool);
+
+		if (!rv)
+			return std::unexpected(rv.error());
+
+		Statistics::cdf_t cdf{ rv->m_minimum, rv->Dense() };
+
+		switch (req.m_unknown)
+		{
+		case unknown_t::DC:
+		case unknown_t::BONUS:
+		{
+			// P(X + bonus >= DC) == P(X >= DC - bonus), so the least bonus brings the DC down to the highest one passed.
+			auto const dc = cdf.HighestDC(req.m_chance);
+
+			if (!dc)
+				return std::unexpected(std::format(u8"無效輸入：無論如何都達不到{}%。\n", req.m_chance * 100.0));
+
+			if (req.m_unknown == unknown_t::DC)
+				return answer_t{ .m_value{ *dc }, .m_chance{ cdf.Challenge(*dc) } };
+
+			return answer_t{ .m_value{ *req.m_dc - *dc }, .m_chance{ cdf.Challenge(*dc) } };
+		}
+
+		case unknown_t::DICE:
+		{
+			Algebra::domain_t const domain{};
+			auto const die = domain.Dice(1, req.m_face);
+
+			if (!die)
+				return std::unexpected(die.error());
+
+			for (int16_t extra = 0; extra <= MAX_EXTRA_DICE; ++extra)
+			{
+				if (auto const flPass = cdf.Challenge(*req.m_dc); flPass >= req.m_chance - Statistics::cdf_t::TARGET_SLACK)
+					return answer_t{ .m_value{ extra }, .m_chance{ flPass } };
+
+				rv = domain.Apply(Bytecode::op_t::ADD, *rv, *die);
+
+				if (!rv)
+					return std::unexpected(std::format(u8"無效輸入：加到第{}顆d{}時結果超出可分析範圍，仍未達到{}%。\n", extra + 1, req.m_face, req.m_chance * 100.0));
+
+				cdf.Assign(rv->m_minimum, rv->Dense());
+			}
+
+			return std::unexpected(std::format(u8"無效輸入：再加{}顆d{}也達不到{}%。\n", MAX_EXTRA_DICE, req.m_face, req.m_chance * 100.0));
+		}
+
+		default:
+			std::unreachable();
+		}
+	}
+}
+
+// Values of the variables for one line, while the compiled expression is shared by every line of the same text.
+// e.g. let STR=3 PB=2: 1d8 + STR + PB
+namespace Let
+{
+	struct request_t final
+	{
+		std::shared_ptr<Bytecode::program_t const> m_program{};
+		vector<int32_t> m_bindings{};	// by slot of m_program.
+	};
+
+	// A whole field, as a variable may well be named letter.
+	constexpr bool Required(string_view sz) noexcept { return sz.starts_with("let") && sz.find_first_of(" \t:", 3) == 3; }
+
+	static_assert(Required("let STR=3: 1d8 + STR") && Required("let: 2d6") && !Required("letter + 1d6") && !Required("let"));
+
+	std::expected<request_t, string> Parse(string_view sz) noexcept
+	{
+		auto const parts = Query::Split(sz, "let");
+
+		if (!parts)
+			return std::unexpected(string{ u8"格式錯誤：算式須以':'隔開。\n\t例如：let STR=3 PB=2: 1d8 + STR + PB\n" });
+
+		auto program = Algebra::Program(parts->m_body);
+
+		if (!program)
+			return std::unexpected(program.error());
+
+		request_t ret{ .m_program{ std::move(*program) } };
+		vector<std::optional<int32_t>> rgValues(ret.m_program->m_variables.size());
+
+		for (auto&& szField : parts->m_fields)
+		{
+			auto const eq = szField.find('=');
+			auto const slot = eq == szField.npos ? std::nullopt : ret.m_program->SlotOf(szField.substr(0, eq));
+			auto const val = eq == szField.npos ? std::nullopt : Query::NumberOf<int32_t>(szField.substr(eq + 1));
+
+			if (eq == szField.npos || !val)
+				return std::unexpected(std::format(u8"格式錯誤：變數須寫作名稱=整數。\n\t錯誤位於'{}'處。\n", szField));
+
+			if (!slot)
+				return std::unexpected(std::format(u8"無效輸入：變數'{}'未出現在算式中。\n", szField.substr(0, eq)));
+
+			if (rgValues[*slot])
+				return std::unexpected(std::format(u8"格式錯誤：變數重複指定。\n\t錯誤位於'{}'處。\n", szField));
+
+			rgValues[*slot] = *val;
+		}
+
+		// Up to the first one left unbound, which Bytecode::Execute() then reports by name.
+		for (auto&& val : rgValues | std::views::take_while([](auto&& val) noexcept { return val.has_value(); }))
+			ret.m_bindings.push_back(*val);
+
+		return ret;
+	}
+
+	inline Algebra::result_t Evaluate(request_t const& req) noexcept
+	{
+		return Algebra::Evaluate(*req.m_program, req.m_bindings);
+	}
+
+	inline Algebra::result_t Evaluate(string_view sz) noexcept
+	{
+		auto const req = Parse(sz);
+
+		if (!req)
+			return std::unexpected(req.error());
+
+		return Evaluate(*req);
+	}
+}
+
+struct auto_timer_t final
+{
+	auto_timer_t() noexcept
+		: m_start{ std::chrono::high_resolution_clock::now() }
+	{
+	}
+
+	auto_timer_t(auto&&...) noexcept = delete;
+	auto_timer_t& operator= (auto&&...) noexcept = delete;
+	~auto_timer_t() noexcept
+	{
+		auto const end_time = std::chrono::high_resolution_clock::now();
+		auto const delta = end_time - m_start;
+
+		std::println(u8"╔══════════════════════╗");
+		std::println(u8"║ Time passed: {:.4f}s ║", std::chrono::duration_cast<std::chrono::nanoseconds>(delta).count() / (double)1e9);
+		std::println(u8"╚══════════════════════╝");
+	}
+
+	decltype(std::chrono::high_resolution_clock::now()) m_start{};
+};
+
+// Histogram, confidence and interval estimate. Common to all kinds of input.
+Statistics::cdf_t PrintDistribution(int32_t iMin, vector<double> const& percentages) noexcept
+{
+	std::print(u8"\n");
+
+	auto const peak = std::ranges::max(percentages);	// for normalizing graph
+	auto const max_digits = Arithmatic::DigitsOf(iMin + percentages.size() - 1);
+
+	for (auto&& [damage, percentage] : std::views::zip(std::views::iota(iMin), percentages))
+		std::print(u8"{0:>{4}}: {1:>5.2f}% - {3:─<{2}}\n", damage, percentage * 100, (int)std::round(percentage / peak * 100), "", max_digits);
+
+	std::print(u8" - 計：{}\n", percentages.size());
+
+	Statistics::cdf_t cdf{ iMin, percentages };
+
+	std::print(u8"\n");
+	std::print(u8"存在70%之可能性使結果 >= {}\n", cdf.Confidence(0.7));
+	std::print(u8"存在80%之可能性使結果 >= {}\n", cdf.Confidence(0.8));
+	std::print(u8"存在90%之可能性使結果 >= {}\n", cdf.Confidence(0.9));
+	std::print(u8"絕對信心值 == {}\n", cdf.Confidence());
+
+	std::print(u8"\n");
+
+	auto const OneSigma = cdf.IntervalEstimate(0.682689492137);
+	auto const TwoSigma = cdf.IntervalEstimate(0.954499736104);
+	auto const ThreeSigma = cdf.IntervalEstimate(0.997300203937);
+
+	std::print(u8"高斯分佈數據：\n");
+	std::print(u8"1σ: [{} - {}]\n", OneSigma.first, OneSigma.second);
+	std::print(u8"2σ: [{} - {}]\n", TwoSigma.first, TwoSigma.second);
+	std::print(u8"3σ: [{} - {}]\n", ThreeSigma.first, ThreeSigma.second);
+
+	std::print(u8"\n");
+
+	return cdf;
+}
+
+void PrintDiceStat(int16_t modifier, vector<int16_t> const& dice, vector<double> const& percentages) noexcept
+{
+	std::print(u8"骰子：{}\n", Dice::ToString(modifier, dice));
+
+	auto const [iMin, iMax] = Statistics::Range(modifier, dice);
+
+	std::print(u8"潛在結果：{}\n", Statistics::ExactPossibilities(dice).ToString());
+	std::print(u8"範圍：[{} - {}]\n期朢值：{}\n", iMin, iMax, Statistics::Expectation(modifier, dice));
+	auto const cdf = PrintDistribution(iMin, percentages);
+
+	// extra info for skill test mode.
+	if (Dice::Count(dice, 20) == 1)
+	{
+		auto const TwoCharactersWide = std::formatted_size(u8" {} ", u8"二字") + 2;
+		auto const ThreeCharactersWide = std::formatted_size(u8" {} ", u8"三個字") + 1 + 2;
+
+		std::print(u8"╔{0:═^{1}}╤{0:═^{2}}╤{0:═^{1}}╤{0:═^{1}}╗\n", "", TwoCharactersWide, ThreeCharactersWide);
+		std::print(u8"║{0:^{4}}│{1:^{5}}│{2:^{4}}│{3:^{4}}║\n", u8"難度", u8"成功率", u8"優勢", u8"劣勢", TwoCharactersWide, ThreeCharactersWide);
+		std::print(u8"╟{0:─^{1}}┼{0:─^{2}}┼{0:─^{1}}┼{0:─^{1}}╢\n", "", TwoCharactersWide, ThreeCharactersWide);
+
+		static constexpr array rgiChallenges{ 2, 5, -1, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, -1, 25, 30, 35 };
+
+		auto modifier_dice{ dice };
+		std::erase(modifier_dice, 20);	// erase all d20
+
+		auto const [adv_percentages, disadv_percentages] = AbilityCheck::Percentages(modifier, modifier_dice, array{ AbilityCheck::ADVANTAGED_D20, AbilityCheck::DISADVANTAGED_D20 });
+		Statistics::cdf_t const adv_cdf{ iMin, adv_percentages };
+		Statistics::cdf_t const disadv_cdf{ iMin, disadv_percentages };
+
+		for (auto i : rgiChallenges)
+		{
+			if (i < 1)
+			{
+				std::print(u8"╟{0:─^{1}}┼{0:─^{2}}┼{0:─^{1}}┼{0:─^{1}}╢\n", "", TwoCharactersWide, ThreeCharactersWide);
+				continue;
+			}
+
+			auto const pass = cdf.Challenge(i);
+			auto const pass_when_adv = adv_cdf.Challenge(i);
+			auto const pass_when_disadv = disadv_cdf.Challenge(i);
+
+			std::print(
+				u8"║{0:^{4}}│{1:^{5}}│{2:^{4}}│{3:^{4}}║\n",
+				i,
+				std::format("{:.2f}%", pass * 100.0),
+				std::format("{:.2f}%", pass_when_adv * 100.0),
+				std::format("{:.2f}%", pass_when_disadv * 100.0), TwoCharactersWide, ThreeCharactersWide
+			);
+		}
+
+		std::print(u8"╚{0:═^{1}}╧{0:═^{2}}╧{0:═^{1}}╧{0:═^{1}}╝\n", "", TwoCharactersWide, ThreeCharactersWide);
+		std::print(u8"\n");
+	}
+}
+
+void PrintDiceStat(int16_t modifier, vector<int16_t> const& dice) noexcept
+{
+	PrintDiceStat(modifier, dice, *PoolCache::Percentages(dice));
+}
+
+void PrintExpressionStat(string_view szExpr, Algebra::random_variable_t const& rv, bool bSuccesses) noexcept
+{
+	std::print(u8"算式：{}\n", szExpr);
+	std::print(u8"範圍：[{} - {}]\n期朢值：{}\n", rv.m_minimum, rv.Maximum(), rv.Expectation());
+
+	if (rv.m_truncation > 0)
+		std::print(u8"爆骰截斷誤差：至多{:.2e}%\n", rv.m_truncation * 100.0);
+
+	auto const cdf = PrintDistribution(rv.m_minimum, rv.Dense());
+
+	// What a pool counting successes is asked: how likely it makes k of them.
+	if (bSuccesses)
+	{
+		for (auto k = std::max(rv.m_minimum, 1); k <= rv.Maximum(); ++k)
+		{
+			if (auto const pass = cdf.Challenge(k); pass >= 0.00005)
+				std::print(u8"至少{}個成功：{:.2f}%\n", k, pass * 100.0);
+		}
+
+		std::print(u8"\n");
+	}
+}
+
+void PrintAttackStat(string_view szInput, Attack::request_t const& req, Algebra::random_variable_t const& rv) noexcept
+{
+	auto const [flMiss, flHit, flCrit] = Attack::Chances(req.m_bonus, req.m_ac, req.m_crit, req.m_d20);
+
+	std::print(u8"攻擊：{}\n", szInput);
+	std::print(u8"每次攻擊：失手{:.2f}%，命中{:.2f}%，重擊{:.2f}%\n", flMiss * 100.0, flHit * 100.0, flCrit * 100.0);
+	std::print(u8"範圍：[{} - {}]\n期朢值：{}\n", rv.m_minimum, rv.Maximum(), rv.Expectation());
+
+	if (rv.m_truncation > 0)
+		std::print(u8"爆骰截斷誤差：至多{:.2e}%\n", rv.m_truncation * 100.0);
+
+	PrintDistribution(rv.m_minimum, rv.Dense());
+}
+
+void PrintOpposedStat(string_view szInput, Opposed::outcome_t const& res) noexcept
+{
+	auto const& diff = res.m_difference;
+
+	std::print(u8"對抗：{}\n", szInput);
+	std::print(u8"勝：{:.2f}%，平：{:.2f}%，負：{:.2f}%\n", res.m_win * 100.0, res.m_tie * 100.0, res.m_loss * 100.0);
+	std::print(u8"差值範圍：[{} - {}]\n差值期朢值：{}\n", diff.m_minimum, diff.Maximum(), diff.Expectation());
+
+	if (diff.m_truncation > 0)
+		std::print(u8"爆骰截斷誤差：至多{:.2e}%\n", diff.m_truncation * 100.0);
+
+	PrintDistribution(diff.m_minimum, diff.Dense());
+}
+
+void PrintSolveStat(string_view szInput, Solve::request_t const& req, Solve::answer_t const& ans) noexcept
+{
+	std::print(u8"求解：{}\n", szInput);
+
+	switch (req.m_unknown)
+	{
+	case Solve::unknown_t::BONUS:
+		std::print(u8"加值至少：{:+}\n", ans.m_value);
+		break;
+
+	case Solve::unknown_t::DC:
+		std::print(u8"難度至多：{}\n", ans.m_value);
+		break;
+
+	case Solve::unknown_t::DICE:
+		std::print(u8"須再加：{}d{}\n", ans.m_value, req.m_face);
+		break;
+
+	default:
+		std::unreachable();
+	}
+
+	std::print(u8"成功率：{:.2f}%，目標{:.2f}%\n\n", ans.m_chance * 100.0, req.m_chance * 100.0);
+}
+
+namespace Batch
+{
+	inline constexpr string_view HEADER = "#expression\tmin\tmax\texpectation\tconfidence70\tconfidence80\tconfidence90\tconfidence\tsigma1\tsigma2\tsigma3\n"sv;
+
+	// UTIL_Trim() stops at the first inner space, which is not what we want for a whole line.
+	constexpr string_view Strip(string_view sz) noexcept
+	{
+		constexpr string_view delimiters{ " \f\n\r\t\v" };
+
+		if (auto const first = sz.find_first_not_of(delimiters); first != sz.npos)
+			return sz.substr(first, sz.find_last_not_of(delimiters) - first + 1);
+
+		return "";
+	}
+
+	static_assert(Strip(" 2d8 + 5\r") == "2d8 + 5" && Strip(" \t") == "");
+
+	// Same numbers as PrintDiceStat(), squeezed into one tab separated line.
+	string Record(string_view szName, int32_t iMin, int32_t iMax, double flExpectation, Statistics::cdf_t const& cdf) noexcept
+	{
+		auto const OneSigma = cdf.IntervalEstimate(0.682689492137);
+		auto const TwoSigma = cdf.IntervalEstimate(0.954499736104);
+		auto const ThreeSigma = cdf.IntervalEstimate(0.997300203937);
+
+		return std::format(
+			"{}\t{}\t{}\t{}\t{}\t{}\t{}\t{}\t{}~{}\t{}~{}\t{}~{}",
+			szName, iMin, iMax, flExpectation,
+			cdf.Confidence(0.7), cdf.Confidence(0.8), cdf.Confidence(0.9), cdf.Confidence(),
+			OneSigma.first, OneSigma.second, TwoSigma.first, TwoSigma.second, ThreeSigma.first, ThreeSigma.second
+		);
+	}
+
+	// Tagged as errors are, as its columns are not the ones of the header.
+	string Opposed(string_view szLine, Opposed::outcome_t const& res) noexcept
+	{
+		return std::format("{}\tOPPOSED\t{}\t{}\t{}", szLine, res.m_win, res.m_tie, res.m_loss);
+	}
+
+	string Solved(string_view szLine, Solve::answer_t const& ans) noexcept
+	{
+		return std::format("{}\tSOLVED\t{}\t{}", szLine, ans.m_value, ans.m_chance);
+	}
+
+	string Error(string_view szLine, string szError) noexcept
+	{
+		// Keep the record in one line.
+		std::ranges::replace_if(szError, [](char c) noexcept { return c == '\n' || c == '\t'; }, ' ');
+
+		return std::format("{}\tERROR\t{}", szLine, Strip(szError));
+	}
+
+	// pCdf is merely a scratch of the calling worker, its buffers are reused all along.
+	string Evaluate(string_view szLine, Statistics::cdf_t* pCdf) noexcept
+	{
+		auto& cdf = *pCdf;
+
+		if (Attack::Required(szLine))
+		{
+			auto const rv = Attack::Evaluate(szLine);
+
+			if (!rv)
+				return Error(szLine, rv.error());
+
+			cdf.Assign(rv->m_minimum, rv->Dense());
+			return Record(szLine, rv->m_minimum, rv->Maximum(), rv->Expectation(), cdf);
+		}
+
+		if (Solve::Required(szLine))
+		{
+			auto const req = Solve::Parse(szLine);
+
+			if (!req)
+				return Error(szLine, req.error());
+
+			auto const ans = Solve::Evaluate(*req);
+
+			if (!ans)
+				return Error(szLine, ans.error());
 
-	inline constexpr auto TWO_D20_RES_COUNT = std::ranges::fold_left(ADVANTAGED_FREQ, 0, std::plus<std::ranges::range_value_t<decltype(ADVANTAGED_FREQ)>>{});
-	static_assert(TWO_D20_RES_COUNT == 400, "Simple math, 20 * 20 == 400");
+			return Solved(szLine, *ans);
+		}
 
-	consteval auto GenerateSample(std::ranges::range auto&& freq)
-	{
-		auto const spl = std::views::enumerate(freq)
-			| std::views::transform([](auto&& obj) { return std::views::repeat(std::get<0>(obj), std::get<1>(obj)); })
-			| std::views::join
-			| std::ranges::to<vector>();
+		// The same formula over many lines, only the values differing, is compiled once.
+		if (Let::Required(szLine))
+		{
+			auto const rv = Let::Evaluate(szLine);
 
-		if (std::ranges::size(spl) != TWO_D20_RES_COUNT)
-			throw std::logic_error("Must be size of 400!");
+			if (!rv)
+				return Error(szLine, rv.error());
 
-		array<uint16_t, TWO_D20_RES_COUNT> ret{};
+			cdf.Assign(rv->m_minimum, rv->Dense());
+			return Record(szLine, rv->m_minimum, rv->Maximum(), rv->Expectation(), cdf);
+		}
 
-		for (auto&& [lhs, rhs] : std::views::zip(ret, spl))
-			lhs = static_cast<std::ranges::range_value_t<decltype(ret)>>(rhs);
+		// A whole matchup matrix is simply one line per pair. Duplicates are already taken care of.
+		if (Opposed::Required(szLine))
+		{
+			auto const res = Opposed::Evaluate(szLine);
 
-		return ret;
-	}
+			if (!res)
+				return Error(szLine, res.error());
 
-	inline constexpr auto ADVANTAGED_SAMPLE = GenerateSample(ADVANTAGED_FREQ);
-	inline constexpr auto DISADVANTAGED_SAMPLE = GenerateSample(DISADVANTAGED_FREQ);
+			return Batch::Opposed(szLine, *res);
+		}
 
-	constexpr auto Percentages(int16_t modifier, vector<int16_t> const& dice, std::ranges::input_range auto&& spl) noexcept
-	{
-		auto const iTotal = Statistics::Possibilities(dice) * TWO_D20_RES_COUNT;
-		auto const lower_bound = Statistics::LowerBound(modifier, dice) + 1;
-		auto const upper_bound = Statistics::UpperBound(modifier, dice) + 20;
-		auto const offset = modifier - lower_bound;
-		auto const should_reserve = upper_bound - lower_bound + 1;
+		if (Algebra::Required(szLine))
+		{
+			auto const rv = Algebra::Evaluate(szLine);
 
-		vector<uint32_t> ret{};	// flat map? #UPDATE_AT_CPP23_flat_meow
-		ret.resize(should_reserve);
+			if (!rv)
+				return Error(szLine, rv.error());
 
-		auto const fnIterateAllDice =
-			[&](this auto&& self, int16_t val, size_t index) noexcept
-			{
-				if (index == dice.size())
-				{
-					++ret[val + offset];
-					return;
-				}
+			cdf.Assign(rv->m_minimum, rv->Dense());
+			return Record(szLine, rv->m_minimum, rv->Maximum(), rv->Expectation(), cdf);
+		}
 
-				auto const start = dice[index] < 0 ? dice[index] : 1;
-				auto const stop = dice[index] < 0 ? -1 : dice[index];
+		auto const parsed = Dice::Parse(string{ szLine });
 
-				for (auto i = start; i <= stop; ++i)
-				{
-					self(val + i, index + 1);
-				}
-			};
+		if (!parsed)
+			return Error(szLine, parsed.error());
 
-		for (auto&& d20_value : spl)
-			fnIterateAllDice(d20_value, 0);
+		auto const& [modifier, dice] = *parsed;
+		auto const [iMin, iMax] = Statistics::Range(modifier, dice);
 
-		return
-			ret
-			| std::views::transform([&](auto&& cnt) noexcept { auto const gcd_ = Arithmatic::gcd(cnt, iTotal); return (double)(cnt / gcd_) / double(iTotal / gcd_); })
-			| std::ranges::to<vector>();
+		cdf.Assign(iMin, *PoolCache::Percentages(dice));
+		return Record(szLine, iMin, iMax, Statistics::Expectation(modifier, dice), cdf);
 	}
-}
 
-namespace Dice
-{
-	struct Arrange final
+	// Started once per process, the daemon shares it between all of its connections.
+	inline worker_pool_t& Workers() noexcept
 	{
-		/*#UPDATE_AT_CPP23_static_operator*/ constexpr bool operator() (int16_t lhs, int16_t rhs) const noexcept
-		{
-			/*
-			purpose:
-				replacement of std::less when dice involved.
-				positive dice always goes first, and negative dice follows.
-				e.g.
-					d4 d4 d6 d10 -d4 -d8
-			*/
-
-			auto const bLhsPositive = lhs > 0;
-			auto const bRhsPositive = rhs > 0;
-
-			if (bLhsPositive && bRhsPositive)
-				return lhs < rhs;	// d4 < d6
+		static worker_pool_t pool{ std::max(1u, std::thread::hardware_concurrency()) - 1 };
+		return pool;
+	}
 
-			if (bLhsPositive && !bRhsPositive)
-				return true;	// d4 < -d4
+	// Newline separated expressions from a file, or from stdin if path is "-". One record per line on stdout, in order.
+	// No console clearing, no pausing, scripting friendly.
+	int Run(string_view szPath) noexcept
+	{
+		std::ifstream file{};
+		std::istream* pInput = &std::cin;
 
-			if (!bLhsPositive && bRhsPositive)
-				return false;	// -d4 > d4
+		if (szPath != "-")
+		{
+			file.open(string{ szPath });
 
-			if (!bLhsPositive && !bRhsPositive)
-				return lhs > rhs;	// -d4 < -d6, but methmatically -4 is greater than -6, so...
+			if (!file)
+			{
+				std::print(stderr, u8"無法開啟檔案'{}'\n", szPath);
+				return 1;
+			}
 
-			std::unreachable();
+			pInput = &file;
 		}
-	};
 
-	constexpr void Sort(vector<int16_t>* prgiDice) noexcept { std::ranges::sort(*prgiDice, Arrange{}); }
+		// Duplicated lines are evaluated only once.
+		// Bounded, as a nightly job could feed millions of distinct lines.
+		static constexpr size_t MAX_MEMORIZED = 1 << 20;
+		std::unordered_map<string, string> computed{};
 
-	constexpr auto Count(vector<int16_t> const& dice, int16_t face) noexcept { return std::ranges::count(dice, face); }
+		// Lines are taken block by block, new ones of a block are spread over all cores.
+		static constexpr size_t BLOCK_SIZE = 4096;
+		auto& workers = Workers();
+		vector<Statistics::cdf_t> rgScratch(workers.Size());
+		vector<string const*> rgpRecords{};
+		vector<pair<string_view, string*>> rgPending{};
 
-	string ToString(int16_t modifier, vector<int16_t> const& dice) noexcept
-	{
-		static constexpr std::array POS_DIE_TYPES{ 4, 6, 8, 10, 12, 20, };
-		static constexpr std::array NEG_DIE_TYPES{ -4, -6, -8, -10, -12, -20, };	// #UPDATE_AT_CPP26_static_in_constexpr_fn
+		string szLine{};
+		string szOutput{ HEADER };
 
-		string ret{};
+		for (bool bEOF = false; !bEOF;)
+		{
+			if (computed.size() >= MAX_MEMORIZED)
+				computed.clear();
 
-		// normal dice first, then debuffs.
-		// hide '1' from 1d4.
+			rgpRecords.clear();
+			rgPending.clear();
 
-		for (auto&& type : POS_DIE_TYPES)
-			if (auto const count = Count(dice, type); count > 0)
-				ret += std::format("{}d{}", count == 1 ? "+"s : std::format("{:+}", count), type);
+			while (rgpRecords.size() < BLOCK_SIZE && !(bEOF = !std::getline(*pInput, szLine)))
+			{
+				// Nodes of unordered_map stay where they are, pointers survive further insertions.
+				auto const [it, bNew] = computed.try_emplace(string{ Strip(szLine) });
 
-		for (auto&& type : NEG_DIE_TYPES)
-			if (auto const count = Count(dice, type); count > 0)
-				ret += std::format("{}d{}", count == 1 ? "-"s : std::format("{}", -count), -type);
+				if (bNew)
+					rgPending.emplace_back(it->first, &it->second);
 
-		if (modifier)
-			ret += std::format("{:+}", modifier);
+				rgpRecords.push_back(&it->second);
+			}
 
-		if (!ret.empty() && ret.front() == '+')
-			ret.erase(ret.begin());
+			// Each job writes into its own record only, and nothing is inserted meanwhile.
+			workers.ParallelFor(
+				rgPending.size(), span{ rgScratch },
+				[&](size_t i, Statistics::cdf_t& cdf) noexcept { *rgPending[i].second = Evaluate(rgPending[i].first, &cdf); }
+			);
 
-		for (auto it = ret.begin(); it != ret.end(); ++it)
-		{
-			if ("^*/%+-"sv.contains(*it))
+			for (auto&& pRecord : rgpRecords)
 			{
-				it = ret.insert(it, ' ');
-				it += 2;
-				it = ret.insert(it, ' ');
-				// now iter points to the inserted space, not the operator.
+				szOutput += *pRecord;
+				szOutput += '\n';
+			}
+
+			if (szOutput.size() >= (1 << 16))
+			{
+				std::fwrite(szOutput.data(), 1, szOutput.size(), stdout);
+				szOutput.clear();
 			}
 		}
 
-		return ret;
+		std::fwrite(szOutput.data(), 1, szOutput.size(), stdout);
+		std::fflush(stdout);
+
+		return 0;
 	}
 }
 
-struct auto_timer_t final
+// Benchmark only, i.e. the Benchmark configuration of the project, which defines DICE_BENCHMARK.
+// Other modes keep the allocator as it is, never paying for the count.
+#ifdef DICE_BENCHMARK
+// Replaced for the sole purpose of counting, Benchmark reports allocations per op.
+void* operator new(size_t size)
 {
-	auto_timer_t() noexcept
-		: m_start{ std::chrono::high_resolution_clock::now() }
-	{
-	}
+	++Benchmark::t_allocations;
 
-	auto_timer_t(auto&&...) noexcept = delete;
-	auto_timer_t& operator= (auto&&...) noexcept = delete;
-	~auto_timer_t() noexcept
-	{
-		auto const end_time = std::chrono::high_resolution_clock::now();
-		auto const delta = end_time - m_start;
+	if (auto const p = std::malloc(size ? size : 1); p)
+		return p;
 
-		std::println(u8"╔══════════════════════╗");
-		std::println(u8"║ Time passed: {:.4f}s ║", std::chrono::duration_cast<std::chrono::nanoseconds>(delta).count() / (double)1e9);
-		std::println(u8"╚══════════════════════╝");
-	}
+	throw std::bad_alloc{};
+}
 
-	decltype(std::chrono::high_resolution_clock::now()) m_start{};
-};
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
 
-void PrintDiceStat(int16_t modifier, vector<int16_t> const& dice) noexcept
+namespace Bench
 {
-	std::print(u8"骰子：{}\n", Dice::ToString(modifier, dice));
+	// Mixed positive and negative faces, the kind Dice::Arrange has to sort.
+	vector<int16_t> PoolOf(size_t count) noexcept
+	{
+		static constexpr array<int16_t, 9> rgiFaces{ 6, -4, 8, 20, -6, 10, 12, -8, 4 };
 
-	auto const possibilities = Statistics::Possibilities(dice);
-	auto const [iMin, iMax] = Statistics::Range(modifier, dice);
-	auto const offset = modifier - iMin;
+		auto ret =
+			std::views::iota((size_t)0, count)
+			| std::views::transform([](size_t i) noexcept { return rgiFaces[i % rgiFaces.size()]; })
+			| std::ranges::to<vector>();
 
-	std::print(u8"潛在結果：{}\n", possibilities);
-	std::print(u8"範圍：[{} - {}]\n期朢值：{}\n", iMin, iMax, Statistics::Expectation(modifier, dice));
-	std::print(u8"\n");
+		Dice::Sort(&ret);
+		return ret;
+	}
 
-	auto const percentages = Statistics::Percentages(modifier, dice);
-	auto const peak = std::ranges::max(percentages);	// for normalizing graph
-	auto const max_digits = Arithmatic::DigitsOf(iMin + percentages.size() - 1);
+	// Plain integers only, which is what PostfixNotationEval() takes. e.g. 1 + 2 * 3 - 4
+	string ArithmeticOf(size_t count) noexcept
+	{
+		string ret{ "1" };
 
-	for (auto&& [damage, percentage] : std::views::zip(std::views::iota(iMin), percentages))
-		std::print(u8"{0:>{4}}: {1:>5.2f}% - {3:─<{2}}\n", damage, percentage * 100, (int)std::round(percentage / peak * 100), "", max_digits);
+		for (size_t i = 1; i < count; ++i)
+			std::format_to(std::back_inserter(ret), " {} {}", "+*-"[i % 3], i % 9 + 1);
 
-	std::print(u8" - 計：{}\n", percentages.size());
+		return ret;
+	}
 
-	std::print(u8"\n");
-	std::print(u8"存在70%之可能性使結果 >= {}\n", Statistics::Confidence(iMin, percentages, 0.7));
-	std::print(u8"存在80%之可能性使結果 >= {}\n", Statistics::Confidence(iMin, percentages, 0.8));
-	std::print(u8"存在90%之可能性使結果 >= {}\n", Statistics::Confidence(iMin, percentages, 0.9));
-	std::print(u8"絕對信心值 == {}\n", Statistics::Confidence(iMin, percentages));
+	// stdout goes to NUL for the whole run, so that PrintDiceStat() costs formatting rather than the console.
+	// Results are written to szOutput as JSON lines, the summary to stderr.
+	int Run(string_view szOutput, string_view szBaseline) noexcept
+	{
+		using Benchmark::DoNotOptimize;
+		using Benchmark::Measure;
 
-	std::print(u8"\n");
+		static constexpr array<size_t, 9> rgSizes{ 1, 2, 4, 8, 16, 32, 64, 128, 256 };
+		static constexpr int16_t MODIFIER = 3;
+
+		// Nothing at compile time reaches FFT. Hold it to PROBABILITY_ULPS before anything is timed, the 19d10 fits but goes through FFT all the same.
+		for (auto&& dice : { PoolOf(64), PoolOf(256), vector<int16_t>(19, 10) })
+		{
+			if (auto const ulps = Statistics::DeviationOf(dice, Convolution::Pool<double>(dice)); ulps > Statistics::PROBABILITY_ULPS)
+			{
+				std::print(stderr, u8"內部錯誤：{}顆骰子的機率誤差為{:.1f} ULP，超出PROBABILITY_ULPS。\n", dice.size(), ulps);
+				return 1;
+			}
+		}
 
-	auto const OneSigma = Statistics::IntervalEstimate(percentages, iMin, iMax, 0.682689492137);
-	auto const TwoSigma = Statistics::IntervalEstimate(percentages, iMin, iMax, 0.954499736104);
-	auto const ThreeSigma = Statistics::IntervalEstimate(percentages, iMin, iMax, 0.997300203937);
+		std::freopen("NUL", "w", stdout);
 
-	std::print(u8"高斯分佈數據：\n");
-	std::print(u8"1σ: [{} - {}]\n", OneSigma.first, OneSigma.second);
-	std::print(u8"2σ: [{} - {}]\n", TwoSigma.first, TwoSigma.second);
-	std::print(u8"3σ: [{} - {}]\n", ThreeSigma.first, ThreeSigma.second);
+		vector<Benchmark::result_t> rgResults{};
 
-	std::print(u8"\n");
+		for (auto&& n : rgSizes)
+		{
+			auto const dice = PoolOf(n);
 
-	// extra info for skill test mode.
-	if (Dice::Count(dice, 20) == 1)
-	{
-		auto const TwoCharactersWide = std::formatted_size(u8" {} ", u8"二字") + 2;
-		auto const ThreeCharactersWide = std::formatted_size(u8" {} ", u8"三個字") + 1 + 2;
+			// Counts wrap around beyond 64 bits, no point timing garbage. Pools only grow from here.
+			if (!Statistics::CountFits(dice))
+				break;
 
-		std::print(u8"╔{0:═^{1}}╤{0:═^{2}}╤{0:═^{1}}╤{0:═^{1}}╗\n", "", TwoCharactersWide, ThreeCharactersWide);
-		std::print(u8"║{0:^{4}}│{1:^{5}}│{2:^{4}}│{3:^{4}}║\n", u8"難度", u8"成功率", u8"優勢", u8"劣勢", TwoCharactersWide, ThreeCharactersWide);
-		std::print(u8"╟{0:─^{1}}┼{0:─^{2}}┼{0:─^{1}}┼{0:─^{1}}╢\n", "", TwoCharactersWide, ThreeCharactersWide);
+			auto const [iMin, iMax] = Statistics::Range(MODIFIER, dice);
+			rgResults.push_back(Measure("Statistics::Distribution", n, [&]() noexcept { DoNotOptimize(Statistics::Distribution(MODIFIER, iMin, iMax, dice)); }));
+		}
 
-		static constexpr array rgiChallenges{ 2, 5, -1, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, -1, 25, 30, 35 };
+		for (auto&& n : rgSizes)
+		{
+			auto const dice = PoolOf(n);
+			rgResults.push_back(Measure("Statistics::Percentages", n, [&]() noexcept { DoNotOptimize(Statistics::Percentages(MODIFIER, dice)); }));
+		}
 
-		auto modifier_dice{ dice };
-		std::erase(modifier_dice, 20);	// erase all d20
+		for (auto&& n : rgSizes)
+		{
+			auto const dice = PoolOf(n);
+			rgResults.push_back(Measure("AbilityCheck::Percentages", n, [&]() noexcept { DoNotOptimize(AbilityCheck::Percentages(MODIFIER, dice, AbilityCheck::ADVANTAGED_D20)); }));
+		}
 
-		auto const adv_percentages = AbilityCheck::Percentages(modifier, modifier_dice, AbilityCheck::ADVANTAGED_SAMPLE);
-		auto const disadv_percentages = AbilityCheck::Percentages(modifier, modifier_dice, AbilityCheck::DISADVANTAGED_SAMPLE);
+		for (auto&& n : rgSizes)
+		{
+			auto const szExpr = Dice::ToString(MODIFIER, PoolOf(n));
+			rgResults.push_back(Measure("ShuntingYardAlgorithm", n, [&]() noexcept { DoNotOptimize(ShuntingYardAlgorithm(szExpr)); }));
+		}
 
-		for (auto i : rgiChallenges)
+		for (auto&& n : rgSizes)
 		{
-			if (i < 1)
-			{
-				std::print(u8"╟{0:─^{1}}┼{0:─^{2}}┼{0:─^{1}}┼{0:─^{1}}╢\n", "", TwoCharactersWide, ThreeCharactersWide);
-				continue;
-			}
+			auto const szExpr = ArithmeticOf(n);
+			auto const program = Bytecode::Compile(ShuntingYardAlgorithm(szExpr));
+			rgResults.push_back(Measure("PostfixNotationEval", n, [&]() noexcept { DoNotOptimize(PostfixNotationEval(*program, {})); }));
+		}
 
-			auto const pass = Statistics::Challenge(iMin, percentages, i);
-			auto const pass_when_adv = Statistics::Challenge(iMin, adv_percentages, i);
-			auto const pass_when_disadv = Statistics::Challenge(iMin, disadv_percentages, i);
+		for (auto&& n : rgSizes)
+		{
+			auto const dice = PoolOf(n);
+			auto const percentages = Statistics::Percentages(MODIFIER, dice);
+			rgResults.push_back(Measure("PrintDiceStat", n, [&]() noexcept { PrintDiceStat(MODIFIER, dice, percentages); }));
+		}
 
-			std::print(
-				u8"║{0:^{4}}│{1:^{5}}│{2:^{4}}│{3:^{4}}║\n",
-				i,
-				std::format("{:.2f}%", pass * 100.0),
-				std::format("{:.2f}%", pass_when_adv * 100.0),
-				std::format("{:.2f}%", pass_when_disadv * 100.0), TwoCharactersWide, ThreeCharactersWide
-			);
+		if (std::ofstream file{ string{ szOutput } }; file)
+			file << Benchmark::ToJsonLines(rgResults);
+		else
+			std::print(stderr, u8"無法寫入檔案'{}'\n", szOutput);
+
+		vector<Benchmark::result_t> rgBaseline{};
+
+		if (!szBaseline.empty())
+		{
+			if (std::ifstream file{ string{ szBaseline } }; file)
+				rgBaseline = Benchmark::FromJsonLines(string{ std::istreambuf_iterator<char>{ file }, {} });
+			else
+				std::print(stderr, u8"無法開啟檔案'{}'\n", szBaseline);
 		}
 
-		std::print(u8"╚{0:═^{1}}╧{0:═^{2}}╧{0:═^{1}}╧{0:═^{1}}╝\n", "", TwoCharactersWide, ThreeCharactersWide);
-		std::print(u8"\n");
+		Benchmark::Report(rgResults, rgBaseline);
+		return 0;
 	}
 }
+#endif
 
 int main(int argc, char* argv[]) noexcept
 {
+	// DiceEstimater --store=<path> ...
+	// Shares computed pools with other runs and processes through that file. Goes before any of the modes below.
+	if (argc > 1 && string_view{ argv[1] }.starts_with("--store="))
+	{
+		PoolCache::StorePath() = string_view{ argv[1] }.substr("--store="sv.size());
+		--argc, ++argv;
+	}
+
+	// DiceEstimater --batch [file]
+	if (argc > 1 && argv[1] == "--batch"sv)
+		return Batch::Run(argc > 2 ? argv[2] : "-");
+
+	// DiceEstimater --bench [output.json] [baseline.json]
+	if (argc > 1 && argv[1] == "--bench"sv)
+	{
+#ifdef DICE_BENCHMARK
+		return Bench::Run(argc > 2 ? argv[2] : "bench.json", argc > 3 ? argv[3] : "");
+#else
+		std::print(stderr, u8"此版本未包含效能測試，請以Benchmark組態建置。\n");
+		return 1;
+#endif
+	}
+
+	// DiceEstimater --daemon [port]
+	// Same records as --batch, one per request frame. Caches and worker threads stay warm in between.
+	if (argc > 1 && argv[1] == "--daemon"sv)
+	{
+		return Server::Run(
+			argc > 2 ? UTIL_StrToNum<uint16_t>(argv[2]) : Server::DEFAULT_PORT,
+			[]() noexcept -> Server::handler_t
+			{
+				// Frames pipelined into one read are spread over the workers Batch::Run() would use.
+				return
+					[rgScratch = vector<Statistics::cdf_t>(Batch::Workers().Size())](span<string_view const> rgszRequests, span<string> rgszResponses) mutable noexcept
+					{
+						Batch::Workers().ParallelFor(
+							rgszRequests.size(), span{ rgScratch },
+							[&](size_t i, Statistics::cdf_t& cdf) noexcept { rgszResponses[i] = Batch::Evaluate(Batch::Strip(rgszRequests[i]), &cdf); }
+						);
+					};
+			}
+		);
+	}
+
 	auto const bSkipPushToContinue = argc > 1;
 	string szInput{};
+	dice_pool_t pool{};	// survives the rounds of interactive mode.
 
 LAB_BEGIN:;
 	if (argc > 1)
 	{
+		// Spaces between arguments still separate the fields of attack and alike.
 		for (auto i = 1; i < argc; ++i)
+		{
+			if (i > 1)
+				szInput += ' ';
+
 			szInput += argv[i];
+		}
 	}
 	else
 	{
 		std::println(u8"輸入骰子及加成總和以分析。");
-		std::println(u8" - 請注意：骰子總數超過8枚時，分析將極為緩慢。");
 		std::println(u8"例如：2d8 + 4d6 + 5\n　　　d20 + d4 + 3 - 1");	// full width space in use. '　', U+3000
 
 		std::getline(std::cin, szInput);
+
+		// empty line or EOF to quit.
+		if (szInput.empty())
+			return 0;
 	}
 
 	if (szInput == "version")
@@ -571,127 +3815,123 @@ LAB_BEGIN:;
 		goto LAB_BEGIN;
 	}
 
-	for (auto&& c : szInput)
+	int16_t modifier{};
+	vector<int16_t> dice{};
+
+	// A round of attacks, e.g. attack 2x +7 vs 16: 1d8 + 4
+	if (Attack::Required(szInput))
 	{
-		if (c == 'D')
-			c = 'd';
+		auto const req = Attack::Parse(szInput);
+		auto const rv = req ? Attack::Evaluate(*req) : Algebra::result_t{ std::unexpected(req.error()) };
 
-		if (!"1234567890d+- "sv.contains(c))
+		if (!rv)
 		{
-			std::print(u8"無效輸入：字元'{}'無法解讀\n", c);
-
-			if (!bSkipPushToContinue)
-				system("pause");
-
-			// cannot 'goto' here. fuck C++.
-			return 1;
+			std::print("{}", rv.error());
+			goto LAB_END;
 		}
-	}
 
-	static constexpr string_view delimiters = "+-"sv;
-	string_view const input_view{ szInput };	// make sure sz.substr() is returning string_view.
-	vector<string_view> identifiers{};
-	bool phase = false;
+		system("cls");
+		PrintAttackStat(szInput, *req, *rv);
+		goto LAB_END;
+	}
 
-	for (size_t pos = input_view.find_first_of(delimiters), last_pos = 0;
-		pos != input_view.npos || last_pos != input_view.npos;
-		phase = !phase, last_pos = pos, pos = (phase ? input_view.find_first_not_of(delimiters, pos) : input_view.find_first_of(delimiters, pos))
-		)
+	// Inverse of the DC table, e.g. solve 65% dc18 bonus?: 1d20 + 1d4
+	if (Solve::Required(szInput))
 	{
-		if (auto const trimmed = UTIL_Trim(input_view.substr(last_pos, pos - last_pos)); trimmed.length())
+		auto const req = Solve::Parse(szInput);
+		auto const ans = req ? Solve::Evaluate(*req) : std::expected<Solve::answer_t, string>{ std::unexpected(req.error()) };
+
+		if (!ans)
 		{
-			if (phase)	// split operators.
-			{
-				for (auto& c : trimmed)
-					identifiers.emplace_back(&c, 1);
-			}
-			else
-				identifiers.emplace_back(trimmed);
+			std::print("{}", ans.error());
+			goto LAB_END;
 		}
-	}
 
-	vector<int16_t> dice{};
-	int16_t modifier = 0;
-	bool negative = false;
-	phase = false;
+		system("cls");
+		PrintSolveStat(szInput, *req, *ans);
+		goto LAB_END;
+	}
 
-	for (auto&& token : identifiers)
+	// Variables of an expression, e.g. let STR=3 PB=2: 1d8 + STR + PB
+	if (Let::Required(szInput))
 	{
-		// non-token?
-		if (token.length() > 1 || !delimiters.contains(token[0]))
-		{
-			// enforce the syntax.
-			if (phase)
-			{
-				std::print(u8"格式錯誤：「運算子」應與「骰子」交替。\n\t錯誤位於'{}'處。\n", token);
-				goto LAB_END;
-			}
-			else if (std::ranges::count(token, 'd') > 1)
-			{
-				std::print(u8"格式錯誤：未指明骰子面數。\n\t錯誤位於'{}'處。\n", token);
-				goto LAB_END;
-			}
+		auto const req = Let::Parse(szInput);
+		auto const rv = req ? Let::Evaluate(*req) : Algebra::result_t{ std::unexpected(req.error()) };
 
-			// Is die?
-			if (auto const pos = token.find('d'); pos != token.npos)
-			{
-				auto const face = UTIL_StrToNum<int16_t>(token.substr(pos + 1)) * (int16_t)(negative ? -1 : 1);
+		if (!rv)
+		{
+			std::print("{}", rv.error());
+			goto LAB_END;
+		}
 
-				// multiple dice
-				if (pos != 0)
-				{
-					dice.append_range(
-						std::views::repeat(
-							face,
-							UTIL_StrToNum<int16_t>(token.substr(0, pos))	// how many?
-						)
-					);
-				}
+		system("cls");
+		PrintExpressionStat(szInput, *rv, req->m_program->Uses(Bytecode::mechanic_t::SUCCESS));
+		goto LAB_END;
+	}
 
-				// only one.
-				else
-					dice.push_back(face);
-			}
+	// One against another, e.g. adv d20 + 5 vs d20 + 3
+	if (Opposed::Required(szInput))
+	{
+		auto const res = Opposed::Evaluate(szInput);
 
-			// Or modifier?
-			else
-				modifier += UTIL_StrToNum<int16_t>(token) * (negative ? -1 : 1);
+		if (!res)
+		{
+			std::print("{}", res.error());
+			goto LAB_END;
 		}
 
-		// operators?
-		else if (delimiters.contains(token[0]))
-		{
-			// enforce the syntax.
-			if (!phase)
-			{
-				std::print(u8"格式錯誤：「運算子」應與「骰子」交替。\n\t錯誤位於'{}'處。\n", token);
-				goto LAB_END;
-			}
+		system("cls");
+		PrintOpposedStat(szInput, *res);
+		goto LAB_END;
+	}
 
-			negative = token[0] == '-';
-		}
+	// Beyond plain sum of dice, e.g. (1d6 + 2) * 2
+	if (Algebra::Required(szInput))
+	{
+		auto const program = Algebra::Program(szInput);
+		auto const rv = program ? Algebra::Evaluate(**program) : Algebra::result_t{ std::unexpected(program.error()) };
 
-		else
+		if (!rv)
 		{
-			std::print(u8"無效輸入：不支援的運算子'{}'\n", token);
+			std::print("{}", rv.error());
 			goto LAB_END;
 		}
 
-		phase = !phase;
+		system("cls");
+		PrintExpressionStat(szInput, *rv, (*program)->Uses(Bytecode::mechanic_t::SUCCESS));
+		goto LAB_END;
 	}
 
-	Dice::Sort(&dice);
+	if (auto parsed = Dice::Parse(std::move(szInput)); parsed)
+		std::tie(modifier, dice) = std::move(*parsed);
+	else
+	{
+		std::print("{}", parsed.error());
+		goto LAB_END;
+	}
 
 	// just timing it for fun.
 	{
 		//auto_timer_t t{};
 		system("cls");
-		PrintDiceStat(modifier, dice);
+
+		if (bSkipPushToContinue)
+			PrintDiceStat(modifier, dice);
+		else
+		{
+			// Keep the histogram from last round and apply the difference only.
+			pool.Assign(modifier, dice);
+			PrintDiceStat(modifier, dice, pool.Percentages());
+		}
 	}
 
 LAB_END:;
 	if (!bSkipPushToContinue)
+	{
 		system("pause");
+		system("cls");
+		goto LAB_BEGIN;
+	}
 
 	return 0;
 }
@@ -0,0 +1,193 @@
+export module Executor;
+
+import std.compat;
+
+// Threads started once and parked in between, so a caller feeding block after block never pays for spawning and joining.
+// Jobs go one at a time, callers from several threads simply queue up on m_submit.
+export struct worker_pool_t final
+{
+	// Helpers besides the calling thread, which always takes part as the first worker.
+	explicit worker_pool_t(size_t helper_count) noexcept
+	{
+		m_rgThreads.reserve(helper_count);
+
+		for (size_t i = 1; i <= helper_count; ++i)
+			m_rgThreads.emplace_back([this, i]() noexcept { Park(i); });
+	}
+
+	~worker_pool_t() noexcept
+	{
+		{
+			std::scoped_lock lock{ m_mutex };
+			m_bStop = true;
+		}
+
+		m_cvStart.notify_all();
+	}	// joined by jthread.
+
+	worker_pool_t(worker_pool_t const&) = delete;
+	worker_pool_t& operator= (worker_pool_t const&) = delete;
+
+	size_t Size() const noexcept { return m_rgThreads.size() + 1; }
+
+	// Loop over [0, count), one worker per scratch object, the calling thread being the first.
+	// Workers start with an even share of the indices and take from the front of their own share.
+	// Once dry, a worker steals the back half of whatever the next busy worker has left.
+	// Costs of items may differ by orders of magnitude, which is exactly where static chunking falls apart.
+	// fn(index, scratch) runs exactly once per index. Results are meant to be written into slot [index], keeping input order.
+	template <typename S, typename F>
+	void ParallelFor(size_t count, std::span<S> rgScratch, F const& fn) noexcept
+	{
+		auto const worker_count = std::min({ count, rgScratch.size(), Size() });
+
+		if (worker_count <= 1)
+		{
+			for (size_t i = 0; i < count; ++i)
+				fn(i, rgScratch.front());
+
+			return;
+		}
+
+		// Own cache line each, or the locks of neighbours would ping-pong.
+		struct alignas(std::hardware_destructive_interference_size) share_t final
+		{
+			std::mutex m_mutex{};
+			size_t m_begin{};
+			size_t m_end{};
+		};
+
+		auto const rgShares = std::make_unique<share_t[]>(worker_count);
+
+		for (size_t i = 0; i < worker_count; ++i)
+		{
+			rgShares[i].m_begin = count * i / worker_count;
+			rgShares[i].m_end = count * (i + 1) / worker_count;
+		}
+
+		auto const fnWorker = [&](size_t self) noexcept
+		{
+			auto& mine = rgShares[self];
+
+			for (;;)
+			{
+				size_t index{};
+				bool bGot = false;
+
+				{
+					std::scoped_lock lock{ mine.m_mutex };
+
+					if (mine.m_begin < mine.m_end)
+					{
+						index = mine.m_begin++;
+						bGot = true;
+					}
+				}
+
+				if (bGot)
+				{
+					fn(index, rgScratch[self]);
+					continue;
+				}
+
+				// Never holding two locks at once, so no ordering to worry about.
+				for (size_t k = 1; k < worker_count && !bGot; ++k)
+				{
+					auto& victim = rgShares[(self + k) % worker_count];
+					size_t begin{}, end{};
+
+					{
+						std::scoped_lock lock{ victim.m_mutex };
+
+						if (victim.m_begin < victim.m_end)
+						{
+							end = victim.m_end;
+							begin = victim.m_end -= (victim.m_end - victim.m_begin + 1) / 2;
+							bGot = true;
+						}
+					}
+
+					if (bGot)
+					{
+						std::scoped_lock lock{ mine.m_mutex };
+						mine.m_begin = begin;
+						mine.m_end = end;
+					}
+				}
+
+				// Everyone is dry. Whatever is still in flight belongs to someone already.
+				if (!bGot)
+					return;
+			}
+		};
+
+		using worker_t = decltype(fnWorker);
+		Dispatch(worker_count - 1, [](void const* pContext, size_t self) noexcept { (*static_cast<worker_t const*>(pContext))(self); }, &fnWorker);
+	}
+
+private:
+	using job_t = void (*)(void const* pContext, size_t self) noexcept;
+
+	// Helpers 1 to helper_count run the job along with the caller, which returns only after all of them are done.
+	void Dispatch(size_t helper_count, job_t pfnJob, void const* pContext) noexcept
+	{
+		std::scoped_lock submit{ m_submit };
+
+		{
+			std::scoped_lock lock{ m_mutex };
+
+			m_pfnJob = pfnJob;
+			m_pContext = pContext;
+			m_helper_count = helper_count;
+			m_pending = helper_count;
+			++m_generation;
+		}
+
+		m_cvStart.notify_all();
+		pfnJob(pContext, 0);
+
+		std::unique_lock lock{ m_mutex };
+		m_cvDone.wait(lock, [this]() noexcept { return m_pending == 0; });
+	}
+
+	void Park(size_t self) noexcept
+	{
+		uint64_t seen{};
+		std::unique_lock lock{ m_mutex };
+
+		for (;;)
+		{
+			m_cvStart.wait(lock, [&]() noexcept { return m_bStop || m_generation != seen; });
+
+			if (m_bStop)
+				return;
+
+			// A job may need fewer hands than there are, those left out simply wait for the next one.
+			seen = m_generation;
+
+			if (self > m_helper_count)
+				continue;
+
+			auto const pfnJob = m_pfnJob;
+			auto const pContext = m_pContext;
+
+			lock.unlock();
+			pfnJob(pContext, self);
+			lock.lock();
+
+			if (--m_pending == 0)
+				m_cvDone.notify_one();
+		}
+	}
+
+	std::mutex m_submit{};
+	std::mutex m_mutex{};
+	std::condition_variable m_cvStart{};
+	std::condition_variable m_cvDone{};
+	job_t m_pfnJob{};
+	void const* m_pContext{};
+	size_t m_helper_count{};
+	size_t m_pending{};
+	uint64_t m_generation{};
+	bool m_bStop{};
+	std::vector<std::jthread> m_rgThreads{};	// last, so the threads are joined before anything above is gone.
+};
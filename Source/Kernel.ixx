@@ -0,0 +1,301 @@
+module;
+
+#include <immintrin.h>
+#include <intrin.h>
+
+export module Kernel;
+
+import std.compat;
+
+using std::span;
+
+// Hand vectorized inner loops of the engine, picked once at runtime from what the CPU offers.
+// MSVC takes AVX2 and AVX-512 intrinsics without /arch, so one binary still runs on anything x64, falling back to plain loops.
+// Multiply-add and search give the very same bits on every path. Sums and scans are reassociated across lanes, off by a few ULP at most.
+export namespace Kernel
+{
+	enum struct isa_t : uint8_t
+	{
+		SCALAR,
+		AVX2,
+		AVX512,	// F and DQ
+	};
+
+	isa_t Detect() noexcept
+	{
+		int regs[4]{};	// eax, ebx, ecx, edx
+
+		__cpuid(regs, 0);
+		auto const max_leaf = regs[0];
+
+		__cpuid(regs, 1);
+		auto const ecx1 = regs[2];
+
+		// The OS must save the wide registers on context switch, or they are not ours to use.
+		if (max_leaf < 7 || !(ecx1 & (1 << 27)) || !(ecx1 & (1 << 28)))
+			return isa_t::SCALAR;
+
+		auto const xcr0 = _xgetbv(0);
+
+		__cpuidex(regs, 7, 0);
+		auto const ebx7 = regs[1];
+
+		if ((xcr0 & 0xE6) == 0xE6 && (ebx7 & (1 << 16)) && (ebx7 & (1 << 17)))
+			return isa_t::AVX512;
+
+		if ((xcr0 & 0x6) == 0x6 && (ebx7 & (1 << 5)))
+			return isa_t::AVX2;
+
+		return isa_t::SCALAR;
+	}
+
+	inline isa_t Isa() noexcept
+	{
+		static auto const isa = Detect();
+		return isa;
+	}
+
+	// rgflDest[k] += flScale * rgflSrc[k]
+	// Multiplied and then added, never fused, so that it agrees with the constant evaluated loop to the last bit.
+	void MultiplyAdd(span<double> rgflDest, double flScale, span<double const> rgflSrc) noexcept
+	{
+		auto const n = std::min(rgflDest.size(), rgflSrc.size());
+		auto const pDest = rgflDest.data();
+		auto const pSrc = rgflSrc.data();
+		size_t i = 0;
+
+		switch (Isa())
+		{
+		case isa_t::AVX512:
+		{
+			auto const scale = _mm512_set1_pd(flScale);
+
+			for (; i + 8 <= n; i += 8)
+				_mm512_storeu_pd(pDest + i, _mm512_add_pd(_mm512_loadu_pd(pDest + i), _mm512_mul_pd(scale, _mm512_loadu_pd(pSrc + i))));
+
+			break;
+		}
+
+		case isa_t::AVX2:
+		{
+			auto const scale = _mm256_set1_pd(flScale);
+
+			for (; i + 4 <= n; i += 4)
+				_mm256_storeu_pd(pDest + i, _mm256_add_pd(_mm256_loadu_pd(pDest + i), _mm256_mul_pd(scale, _mm256_loadu_pd(pSrc + i))));
+
+			break;
+		}
+
+		default:
+			break;
+		}
+
+		for (; i < n; ++i)
+			pDest[i] += flScale * pSrc[i];
+	}
+
+	// rgDest[k] += scale * rgSrc[k], wrapping around just like the scalar one.
+	void MultiplyAdd(span<uint64_t> rgDest, uint64_t scale, span<uint64_t const> rgSrc) noexcept
+	{
+		auto const n = std::min(rgDest.size(), rgSrc.size());
+		auto const pDest = rgDest.data();
+		auto const pSrc = rgSrc.data();
+		size_t i = 0;
+
+		switch (Isa())
+		{
+		case isa_t::AVX512:
+		{
+			auto const vScale = _mm512_set1_epi64((int64_t)scale);
+
+			for (; i + 8 <= n; i += 8)
+				_mm512_storeu_si512(pDest + i, _mm512_add_epi64(_mm512_loadu_si512(pDest + i), _mm512_mullo_epi64(vScale, _mm512_loadu_si512(pSrc + i))));
+
+			break;
+		}
+
+		case isa_t::AVX2:
+		{
+			// No 64 bits multiplication before AVX-512, so lo * lo + ((hi * lo + lo * hi) << 32) out of 32 bits halves.
+			auto const vScale = _mm256_set1_epi64x((int64_t)scale);
+			auto const vScaleHi = _mm256_srli_epi64(vScale, 32);
+
+			for (; i + 4 <= n; i += 4)
+			{
+				auto const src = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(pSrc + i));
+				auto const lo = _mm256_mul_epu32(vScale, src);
+				auto const cross = _mm256_add_epi64(_mm256_mul_epu32(vScaleHi, src), _mm256_mul_epu32(vScale, _mm256_srli_epi64(src, 32)));
+				auto const prod = _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+				auto const dest = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(pDest + i));
+
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(pDest + i), _mm256_add_epi64(dest, prod));
+			}
+
+			break;
+		}
+
+		default:
+			break;
+		}
+
+		for (; i < n; ++i)
+			pDest[i] += scale * pSrc[i];
+	}
+
+	double Sum(span<double const> rgfl) noexcept
+	{
+		auto const n = rgfl.size();
+		auto const p = rgfl.data();
+		size_t i = 0;
+		double ret{};
+
+		switch (Isa())
+		{
+		case isa_t::AVX512:
+		{
+			auto acc = _mm512_setzero_pd();
+
+			for (; i + 8 <= n; i += 8)
+				acc = _mm512_add_pd(acc, _mm512_loadu_pd(p + i));
+
+			ret = _mm512_reduce_add_pd(acc);
+			break;
+		}
+
+		case isa_t::AVX2:
+		{
+			auto acc = _mm256_setzero_pd();
+
+			for (; i + 4 <= n; i += 4)
+				acc = _mm256_add_pd(acc, _mm256_loadu_pd(p + i));
+
+			auto const half = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+			ret = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+			break;
+		}
+
+		default:
+			break;
+		}
+
+		for (; i < n; ++i)
+			ret += p[i];
+
+		return ret;
+	}
+
+	// Index of the first element greater than flThreshold, or the size if none.
+	size_t FindFirstGreater(span<double const> rgfl, double flThreshold) noexcept
+	{
+		auto const n = rgfl.size();
+		auto const p = rgfl.data();
+		size_t i = 0;
+
+		switch (Isa())
+		{
+		case isa_t::AVX512:
+		{
+			auto const threshold = _mm512_set1_pd(flThreshold);
+
+			for (; i + 8 <= n; i += 8)
+			{
+				if (auto const mask = _mm512_cmp_pd_mask(_mm512_loadu_pd(p + i), threshold, _CMP_GT_OQ); mask)
+					return i + std::countr_zero((uint32_t)mask);
+			}
+
+			break;
+		}
+
+		case isa_t::AVX2:
+		{
+			auto const threshold = _mm256_set1_pd(flThreshold);
+
+			for (; i + 4 <= n; i += 4)
+			{
+				if (auto const mask = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(p + i), threshold, _CMP_GT_OQ)); mask)
+					return i + std::countr_zero((uint32_t)mask);
+			}
+
+			break;
+		}
+
+		default:
+			break;
+		}
+
+		for (; i < n; ++i)
+		{
+			if (p[i] > flThreshold)
+				return i;
+		}
+
+		return n;
+	}
+
+	// Scans are carried from one vector to the next, so they stop at AVX2. Wider lanes would only lengthen the shuffles in between.
+
+	// rgflDest[k] = rgflSrc[0] + ... + rgflSrc[k]
+	void PrefixSum(span<double const> rgflSrc, span<double> rgflDest) noexcept
+	{
+		auto const n = std::min(rgflSrc.size(), rgflDest.size());
+		auto const pSrc = rgflSrc.data();
+		auto const pDest = rgflDest.data();
+		size_t i = 0;
+		double carry{};
+
+		if (Isa() != isa_t::SCALAR)
+		{
+			auto const zero = _mm256_setzero_pd();
+			auto vCarry = zero;
+
+			for (; i + 4 <= n; i += 4)
+			{
+				// [a, b, c, d] + [0, a, b, c] makes [a, a + b, b + c, c + d], which then takes [0, 0, a, a + b].
+				auto x = _mm256_loadu_pd(pSrc + i);
+				x = _mm256_add_pd(x, _mm256_blend_pd(_mm256_permute4x64_pd(x, 0b10'01'00'00), zero, 0b0001));
+				x = _mm256_add_pd(x, _mm256_blend_pd(_mm256_permute4x64_pd(x, 0b01'00'00'00), zero, 0b0011));
+				x = _mm256_add_pd(x, vCarry);
+
+				_mm256_storeu_pd(pDest + i, x);
+				vCarry = _mm256_permute4x64_pd(x, 0b11'11'11'11);
+			}
+
+			carry = _mm256_cvtsd_f64(vCarry);
+		}
+
+		for (; i < n; ++i)
+			pDest[i] = (carry += pSrc[i]);
+	}
+
+	// rgflDest[k] = rgflSrc[k] + ... + rgflSrc[n - 1], summed up from the far end.
+	void SuffixSum(span<double const> rgflSrc, span<double> rgflDest) noexcept
+	{
+		auto const pSrc = rgflSrc.data();
+		auto const pDest = rgflDest.data();
+		auto i = std::min(rgflSrc.size(), rgflDest.size());
+		double carry{};
+
+		if (Isa() != isa_t::SCALAR)
+		{
+			auto const zero = _mm256_setzero_pd();
+			auto vCarry = zero;
+
+			for (; i >= 4; i -= 4)
+			{
+				// [a, b, c, d] + [b, c, d, 0] + [c + d, d, 0, 0]
+				auto x = _mm256_loadu_pd(pSrc + i - 4);
+				x = _mm256_add_pd(x, _mm256_blend_pd(_mm256_permute4x64_pd(x, 0b11'11'10'01), zero, 0b1000));
+				x = _mm256_add_pd(x, _mm256_blend_pd(_mm256_permute4x64_pd(x, 0b11'11'11'10), zero, 0b1100));
+				x = _mm256_add_pd(x, vCarry);
+
+				_mm256_storeu_pd(pDest + i - 4, x);
+				vCarry = _mm256_permute4x64_pd(x, 0b00'00'00'00);
+			}
+
+			carry = _mm256_cvtsd_f64(vCarry);
+		}
+
+		for (; i-- > 0;)
+			pDest[i] = (carry += pSrc[i]);
+	}
+}
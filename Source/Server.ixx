@@ -0,0 +1,178 @@
+module;
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <WinSock2.h>
+#include <WS2tcpip.h>
+
+#pragma comment(lib, "Ws2_32.lib")
+
+export module Server;
+
+import std.compat;
+
+using std::string;
+using std::string_view;
+
+// Long running local server, so that a query no longer pays for a whole process.
+// Frames are a little endian uint32_t length followed by that many bytes, both ways.
+// Requests may be pipelined. Responses go out in the same order, all that was answered in one read coalesced into one send().
+export namespace Server
+{
+	inline constexpr uint16_t DEFAULT_PORT = 47020;
+	inline constexpr uint32_t MAX_FRAME = 1 << 16;
+
+	// One per connection, so it may keep its own scratch without locking.
+	// Takes every complete frame of one read at once, rgszResponses[i] answering rgszRequests[i].
+	using handler_t = std::move_only_function<void(std::span<string_view const> rgszRequests, std::span<string> rgszResponses)>;
+
+	void AppendFrame(string* psz, string_view szPayload) noexcept
+	{
+		auto const len = (uint32_t)szPayload.size();
+		char const header[4]{ (char)(len & 0xFF), (char)((len >> 8) & 0xFF), (char)((len >> 16) & 0xFF), (char)((len >> 24) & 0xFF) };
+
+		psz->append(header, 4);
+		psz->append(szPayload);
+	}
+
+	void Converse(SOCKET sock, handler_t fnHandler) noexcept
+	{
+		static constexpr size_t RECV_SIZE = 1 << 16;
+
+		string szInbox{}, szOutbox{};
+		std::vector<string_view> rgszRequests{};
+		std::vector<string> rgszResponses{};
+		auto const pBuffer = std::make_unique<char[]>(RECV_SIZE);
+
+		for (;;)
+		{
+			auto const received = recv(sock, pBuffer.get(), (int)RECV_SIZE, 0);
+
+			if (received <= 0)
+				break;
+
+			szInbox.append(pBuffer.get(), received);
+
+			size_t pos = 0;
+			rgszRequests.clear();
+
+			for (; szInbox.size() - pos >= 4; )
+			{
+				auto const p = reinterpret_cast<uint8_t const*>(szInbox.data() + pos);
+				auto const len = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+
+				// Nothing sane is that long. Not worth waiting for.
+				if (len > MAX_FRAME)
+				{
+					closesocket(sock);
+					return;
+				}
+
+				if (szInbox.size() - pos - 4 < len)
+					break;
+
+				rgszRequests.push_back(string_view{ szInbox }.substr(pos + 4, len));
+				pos += 4 + len;
+			}
+
+			// Grown once, never shrunk, from one read to the next.
+			if (rgszResponses.size() < rgszRequests.size())
+				rgszResponses.resize(rgszRequests.size());
+
+			if (!rgszRequests.empty())
+				fnHandler(rgszRequests, std::span{ rgszResponses }.first(rgszRequests.size()));
+
+			for (auto&& szResponse : std::span{ rgszResponses }.first(rgszRequests.size()))
+				AppendFrame(&szOutbox, szResponse);
+
+			szInbox.erase(0, pos);
+
+			for (size_t sent = 0; sent < szOutbox.size(); )
+			{
+				auto const res = send(sock, szOutbox.data() + sent, (int)(szOutbox.size() - sent), 0);
+
+				if (res <= 0)
+				{
+					closesocket(sock);
+					return;
+				}
+
+				sent += res;
+			}
+
+			szOutbox.clear();
+		}
+
+		closesocket(sock);
+	}
+
+	// Listens on 127.0.0.1 only. Each connection gets its own thread and its own handler from fnNewConnection().
+	int Run(uint16_t port, std::function<handler_t()> const& fnNewConnection) noexcept
+	{
+		WSADATA wsa{};
+
+		if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0)
+		{
+			std::print(stderr, u8"無法初始化Winsock。\n");
+			return 1;
+		}
+
+		auto const listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+		sockaddr_in addr{};
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons(port);
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+		if (listener == INVALID_SOCKET
+			|| bind(listener, reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)) == SOCKET_ERROR
+			|| listen(listener, SOMAXCONN) == SOCKET_ERROR)
+		{
+			std::print(stderr, u8"無法監聽127.0.0.1:{}\n", port);
+			WSACleanup();
+			return 1;
+		}
+
+		std::print(stderr, u8"監聽中：127.0.0.1:{}\n", port);
+
+		static constexpr auto MAX_BACKOFF = std::chrono::milliseconds(1000);
+		std::chrono::milliseconds backoff{};
+
+		for (;;)
+		{
+			auto const sock = accept(listener, nullptr, nullptr);
+
+			if (sock == INVALID_SOCKET)
+			{
+				switch (auto const err = WSAGetLastError())
+				{
+				// The peer gave up before we got to it, nothing wrong with us.
+				case WSAECONNRESET:
+				case WSAEINTR:
+					continue;
+
+				// Out of sockets or buffers. Retrying at once would only spin, so wait for connections to close.
+				case WSAEMFILE:
+				case WSAENOBUFS:
+					backoff = std::min(backoff == backoff.zero() ? std::chrono::milliseconds(10) : backoff * 2, MAX_BACKOFF);
+					std::this_thread::sleep_for(backoff);
+					continue;
+
+				default:
+					std::print(stderr, u8"監聽中斷，錯誤碼：{}\n", err);
+					closesocket(listener);
+					WSACleanup();
+					return 1;
+				}
+			}
+
+			backoff = backoff.zero();
+
+			// Answers are tiny, Nagle would only hold them back.
+			BOOL const no_delay = TRUE;
+			setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<char const*>(&no_delay), sizeof(no_delay));
+
+			std::thread{ &Converse, sock, fnNewConnection() }.detach();
+		}
+	}
+}
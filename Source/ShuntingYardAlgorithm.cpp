@@ -7,6 +7,7 @@
 
 import std.compat;
 
+import Bytecode;
 import Utility;
 
 using std::span;
@@ -53,38 +54,6 @@ namespace Op
 		}
 	}
 
-	inline constexpr size_t ArgCount(char c) noexcept
-	{
-		switch (c)
-		{
-		case '^':
-		case '*':
-		case '/':
-		case '%':
-		case '+':
-		case '-':
-		case '=':
-			return 2;
-
-		case '!':
-			return 1;
-
-		default:
-			return static_cast<size_t>(-1);
-		}
-	}
-
-	inline constexpr bool Test(string_view s) noexcept
-	{
-		for (auto&& c : s)
-		{
-			if (all.contains(c))
-				return true;
-		}
-
-		return false;
-	}
-
 	inline constexpr bool TestExt(string_view s) noexcept
 	{
 		for (auto&& c : s)
@@ -95,54 +64,6 @@ namespace Op
 
 		return false;
 	}
-
-	inline constexpr int32_t Evaluate(char c, span<int32_t> params) noexcept
-	{
-		int32_t ret{};
-
-		switch (c)
-		{
-		case '!':
-		{
-			auto factorial = [](this auto&& self, int32_t n) /*#UPDATE_AT_CPP23_static_operator*/ noexcept -> int32_t { return (n == 1 || n == 0) ? 1 : self(n - 1) * n; };
-			return factorial(params[0]);
-		}
-
-		case '^':
-		{
-			ret = 1;
-			for (int32_t i = 0; i < params[1]; ++i)
-				ret *= params[0];
-
-			return ret;
-		}
-
-		case '*':
-		{
-			return params[0] * params[1];
-		}
-		case '/':
-		{
-			return params[0] / params[1];
-		}
-		case '%':
-		{
-			return params[0] % params[1];
-		}
-
-		case '+':
-		{
-			return params[0] + params[1];
-		}
-		case '-':
-		{
-			return params[0] - params[1];
-		}
-
-		default:
-			std::unreachable();
-		}
-	}
 };
 
 CONSTEXPR vector<string_view> ShuntingYardAlgorithm(string_view s)
@@ -170,6 +91,28 @@ CONSTEXPR vector<string_view> ShuntingYardAlgorithm(string_view s)
 		}
 	}
 
+	// Exploding dice, e.g. 1d6! or 1d6!4, are one token rather than a factorial. Only when nothing stands in between.
+	for (size_t i = 1; i < identifiers.size(); ++i)
+	{
+		auto& prev = identifiers[i - 1];
+		auto const Adjacent = [&](string_view token) noexcept { return prev.data() + prev.size() == token.data(); };
+
+		if (identifiers[i] != "!" || !Adjacent(identifiers[i]) || !Bytecode::IsDice(prev))
+			continue;
+
+		prev = string_view{ prev.data(), prev.size() + 1 };
+		identifiers.erase(identifiers.begin() + i);
+
+		// The depth, and whatever mechanics come after.
+		if (i < identifiers.size() && Adjacent(identifiers[i]) && !Op::TestExt(identifiers[i]))
+		{
+			prev = string_view{ prev.data(), prev.size() + identifiers[i].size() };
+			identifiers.erase(identifiers.begin() + i);
+		}
+
+		--i;	// yet another one may follow.
+	}
+
 	for (auto&& token : identifiers)
 	{
 		// Is number?
@@ -251,32 +194,22 @@ CONSTEXPR vector<string_view> ShuntingYardAlgorithm(string_view s)
 	return ret;
 }
 
-CONSTEXPR int32_t PostfixNotationEval(vector<string_view> const& identifiers) noexcept
+// The hot path: nothing is decoded or allocated here. Keep the program of a formula evaluated over and over, with only the variables changing.
+// Division by zero and unbound variables come out as errors, never as a 0 indistinguishable from the real one.
+CONSTEXPR std::expected<int32_t, string> PostfixNotationEval(Bytecode::program_t const& program, span<int32_t const> rgiBindings) noexcept
 {
-	vector<int32_t> num_stack{};
-
-	for (auto&& token : identifiers)
-	{
-		if (token.length() > 1 || !Op::Test(token))
-		{
-			num_stack.push_back(UTIL_StrToNum<int32_t>(token));
-		}
-		else if (Op::Test(token))
-		{
-			auto const arg_count = Op::ArgCount(token[0]);
-			auto const first_param_pos = num_stack.size() - arg_count;
-			auto const params = span{ num_stack.data() + first_param_pos, arg_count };
+	return Bytecode::Execute<int32_t>(program, rgiBindings, Bytecode::integer_domain_t{});
+}
 
-			auto const res = Op::Evaluate(token[0], params);
+// One-off, the tokens are decoded by Bytecode::Compile() first.
+CONSTEXPR std::expected<int32_t, string> PostfixNotationEval(vector<string_view> const& identifiers) noexcept
+{
+	auto const program = Bytecode::Compile(identifiers);
 
-			num_stack.erase(num_stack.begin() + first_param_pos, num_stack.end());
-			num_stack.push_back(res);
-		}
-		else
-			std::unreachable();
-	}
+	if (!program)
+		return std::unexpected(program.error());
 
-	return num_stack.front();
+	return PostfixNotationEval(*program, {});
 }
 
 #ifdef SYA_AUTO_TEST
@@ -296,7 +229,11 @@ static_assert(SYA_Test());
 consteval bool PN_Test() noexcept
 {
 	auto const rpn = ShuntingYardAlgorithm("3*8/2^3+6^2!-1");
-	return PostfixNotationEval(rpn) == 38;
+	auto const program = Bytecode::Compile(ShuntingYardAlgorithm("(x+4)*2/y"));
+
+	return PostfixNotationEval(rpn) == 38
+		&& program && PostfixNotationEval(*program, std::array{ 2, 3 }) == 4 && PostfixNotationEval(*program, std::array{ 5, 2 }) == 9
+		&& !PostfixNotationEval(*program, std::array{ 1, 0 });
 }
 
 static_assert(PN_Test());
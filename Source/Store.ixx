@@ -0,0 +1,304 @@
+module;
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+
+export module Store;
+
+import std.compat;
+
+using std::span;
+using std::vector;
+
+// Append only file of computed distributions, shared across runs and processes.
+// Readers map the file and visit spans right into the mapping under a lock, nothing is copied.
+// Writers append one whole record per WriteFile() under a file lock. A record torn by a crash is stepped over, never poisons the rest.
+//
+// Layout, all 8 bytes aligned:
+//	header_t
+//	record_t, key int16_t[] padded, counts uint64_t[], percentages double[], trailing copy of record_t::m_hash
+//	...
+export struct distribution_store_t final
+{
+	static inline constexpr uint64_t MAGIC = 0x524F'5453'4543'4944;	// "DICESTOR"
+	static inline constexpr uint32_t VERSION = 1;
+
+	struct view_t final
+	{
+		span<uint64_t const> m_counts{};	// empty if the counts did not fit into 64 bits.
+		span<double const> m_percentages{};
+	};
+
+	explicit distribution_store_t(std::filesystem::path const& path) noexcept
+	{
+		m_file = CreateFileW(
+			path.c_str(),
+			GENERIC_READ | FILE_APPEND_DATA,
+			FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr
+		);
+
+		if (m_file == INVALID_HANDLE_VALUE)
+			return;
+
+		// Whoever comes first writes the header.
+		{
+			file_lock_t lock{ m_file, true };
+
+			if (SizeOnDisk() == 0)
+			{
+				header_t const header{ .m_magic{ MAGIC }, .m_version{ VERSION } };
+				DWORD written{};
+				WriteFile(m_file, &header, sizeof(header), &written, nullptr);
+			}
+		}
+
+		std::unique_lock lock{ m_mutex };
+		Refresh();
+
+		// Different version or not our file at all. Leave it be.
+		if (m_mapped_size < sizeof(header_t))
+			Close();
+	}
+
+	distribution_store_t(distribution_store_t const&) noexcept = delete;
+	distribution_store_t& operator= (distribution_store_t const&) noexcept = delete;
+	~distribution_store_t() noexcept { Close(); }
+
+	bool IsOpen() const noexcept { return m_file != INVALID_HANDLE_VALUE; }
+
+	// fnVisit(view_t) runs under the lock, the spans must not outlive it. Returns whether the key was found at all.
+	// Records appended by others are picked up on a miss, once the file grew by REMAP_GROWTH since the last mapping.
+	// Our own appends are in the caller's memory anyway, remapping the whole file for each of them would only cost address space.
+	template <typename F>
+	bool Find(span<int16_t const> key, uint64_t hash, F&& fnVisit) noexcept
+	{
+		if (!IsOpen())
+			return false;
+
+		{
+			std::shared_lock lock{ m_mutex };
+
+			if (auto const view = Lookup(key, hash); view)
+			{
+				fnVisit(*view);
+				return true;
+			}
+		}
+
+		std::unique_lock lock{ m_mutex };
+
+		if (SizeOnDisk() >= m_mapped_size + REMAP_GROWTH)
+			Refresh();
+
+		if (auto const view = Lookup(key, hash); view)
+		{
+			fnVisit(*view);
+			return true;
+		}
+
+		return false;
+	}
+
+	void Append(span<int16_t const> key, uint64_t hash, span<uint64_t const> counts, span<double const> percentages) noexcept
+	{
+		if (!IsOpen())
+			return;
+
+		record_t const record{
+			.m_hash{ hash },
+			.m_key_size{ (uint32_t)key.size() },
+			.m_count_size{ (uint32_t)counts.size() },
+			.m_percentage_size{ (uint32_t)percentages.size() },
+		};
+
+		// One buffer, one write.
+		vector<std::byte> buffer(record.TotalSize());
+		auto Put =
+			[&, pos = (size_t)0](auto&& rg, size_t padded) mutable noexcept
+			{
+				std::memcpy(buffer.data() + pos, std::data(rg), std::size(rg) * sizeof(*std::data(rg)));
+				pos += padded;
+			};
+
+		Put(span{ &record, 1 }, sizeof(record));
+		Put(key, Align(key.size_bytes()));
+		Put(counts, counts.size_bytes());
+		Put(percentages, percentages.size_bytes());
+		Put(span{ &hash, 1 }, sizeof(hash));
+
+		file_lock_t lock{ m_file, true };
+		DWORD written{};
+
+		// A write torn by a crash may have left the end off the 8 bytes grid, on which records are searched for.
+		if (auto const misaligned = SizeOnDisk() % 8; misaligned)
+		{
+			static constexpr std::byte padding[8]{};
+			WriteFile(m_file, padding, (DWORD)(8 - misaligned), &written, nullptr);
+		}
+
+		WriteFile(m_file, buffer.data(), (DWORD)buffer.size(), &written, nullptr);
+	}
+
+private:
+	struct header_t final
+	{
+		uint64_t m_magic{};
+		uint32_t m_version{};
+		uint32_t m_reserved{};
+	};
+
+	struct record_t final
+	{
+		uint64_t m_hash{};
+		uint32_t m_key_size{};
+		uint32_t m_count_size{};
+		uint32_t m_percentage_size{};
+		uint32_t m_reserved{};
+
+		constexpr size_t TotalSize() const noexcept
+		{
+			// All in size_t, so a garbage header cannot wrap around in uint32_t and slip past IsIntact().
+			return sizeof(record_t) + Align(m_key_size * sizeof(int16_t)) + ((size_t)m_count_size + (size_t)m_percentage_size) * 8 + sizeof(uint64_t);
+		}
+	};
+
+	static_assert(sizeof(header_t) % 8 == 0 && sizeof(record_t) % 8 == 0);
+
+	static inline constexpr size_t REMAP_GROWTH = 1 << 20;
+
+	// Shared for reading, so no append is ever seen half way.
+	struct file_lock_t final
+	{
+		file_lock_t(HANDLE file, bool bExclusive) noexcept : m_file{ file } { LockFileEx(m_file, bExclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0, 0, MAXDWORD, MAXDWORD, &m_overlapped); }
+		~file_lock_t() noexcept { UnlockFileEx(m_file, 0, MAXDWORD, MAXDWORD, &m_overlapped); }
+
+		HANDLE m_file{};
+		OVERLAPPED m_overlapped{};
+	};
+
+	static constexpr size_t Align(size_t bytes) noexcept { return (bytes + 7) & ~(size_t)7; }
+
+	size_t SizeOnDisk() const noexcept
+	{
+		LARGE_INTEGER size{};
+		return GetFileSizeEx(m_file, &size) ? (size_t)size.QuadPart : 0;
+	}
+
+	std::optional<view_t> Lookup(span<int16_t const> key, uint64_t hash) const noexcept
+	{
+		for (auto [it, end] = m_index.equal_range(hash); it != end; ++it)
+		{
+			auto const pRecord = reinterpret_cast<record_t const*>(m_pView + it->second);
+			auto const pKey = reinterpret_cast<int16_t const*>(pRecord + 1);
+
+			if (!std::ranges::equal(span{ pKey, pRecord->m_key_size }, key))
+				continue;
+
+			auto const pCounts = reinterpret_cast<uint64_t const*>(reinterpret_cast<std::byte const*>(pKey) + Align(pRecord->m_key_size * sizeof(int16_t)));
+			auto const pPercentages = reinterpret_cast<double const*>(pCounts + pRecord->m_count_size);
+
+			return view_t{
+				.m_counts{ pCounts, pRecord->m_count_size },
+				.m_percentages{ pPercentages, pRecord->m_percentage_size },
+			};
+		}
+
+		return std::nullopt;
+	}
+
+	// Map the file as it is now in a single view, and index whatever is new.
+	// Only ever called under the unique lock, so no span into the superseded view is left to dangle.
+	void Refresh() noexcept
+	{
+		file_lock_t lock{ m_file, false };
+
+		auto const size = SizeOnDisk();
+
+		if (size <= m_mapped_size)
+			return;
+
+		auto const mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if (!mapping)
+			return;
+
+		auto const pView = static_cast<std::byte const*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size));
+		CloseHandle(mapping);	// the view keeps it alive.
+
+		if (!pView)
+			return;
+
+		if (m_pView)
+			UnmapViewOfFile(m_pView);
+
+		m_pView = pView;
+		m_mapped_size = size;
+
+		auto pos = m_scanned_size;
+
+		if (pos == 0)
+		{
+			auto const pHeader = reinterpret_cast<header_t const*>(pView);
+
+			if (size < sizeof(header_t) || pHeader->m_magic != MAGIC || pHeader->m_version != VERSION)
+			{
+				m_mapped_size = 0;
+				return;
+			}
+
+			pos = sizeof(header_t);
+		}
+
+		while (pos + sizeof(record_t) <= size)
+		{
+			auto const pRecord = reinterpret_cast<record_t const*>(pView + pos);
+
+			// Appends are whole under the file lock, so a mismatch is torn by a crash for good. Look for the next record on the grid.
+			if (!IsIntact(pRecord, size - pos))
+			{
+				pos += 8;
+				continue;
+			}
+
+			m_index.emplace(pRecord->m_hash, pos);
+			pos += pRecord->TotalSize();
+		}
+
+		m_scanned_size = pos;
+	}
+
+	static bool IsIntact(record_t const* pRecord, size_t available) noexcept
+	{
+		// Garbage lengths must not wrap the sum around.
+		if (pRecord->m_key_size == 0 || pRecord->m_key_size > available || pRecord->m_count_size > available || pRecord->m_percentage_size > available)
+			return false;
+
+		auto const total = pRecord->TotalSize();
+
+		return total <= available
+			&& *reinterpret_cast<uint64_t const*>(reinterpret_cast<std::byte const*>(pRecord) + total - sizeof(uint64_t)) == pRecord->m_hash;
+	}
+
+	void Close() noexcept
+	{
+		if (m_pView)
+			UnmapViewOfFile(m_pView);
+
+		m_pView = nullptr;
+		m_index.clear();
+
+		if (m_file != INVALID_HANDLE_VALUE)
+			CloseHandle(m_file);
+
+		m_file = INVALID_HANDLE_VALUE;
+	}
+
+	HANDLE m_file{ INVALID_HANDLE_VALUE };
+	std::shared_mutex m_mutex{};
+	std::byte const* m_pView{};
+	std::unordered_multimap<uint64_t, size_t> m_index{};	// hash -> offset of the record
+	size_t m_mapped_size{};
+	size_t m_scanned_size{};
+};